@@ -4,6 +4,9 @@
 #include<stdlib.h>
 #include<time.h>
 #include<math.h>
+#include<limits.h>
+#include<string.h>
+#include<stdatomic.h>
 
 #include "Board.h"
 #include "Queue.h"
@@ -19,27 +22,66 @@ typedef struct Path {
 
 /* The search algorithm with the relevant path and metadata */
 typedef struct Algorithm {
+    bool Solved;
     unsigned int NodesVisited;
     unsigned int MovesPerformed;
     double ComputationTime;
+    // Proven upper bound on MovesPerformed divided by the optimal number of moves, INFINITY if there is none
+    double Bound;
 
     Path* path;
+    MemoryStats Memory;     // Memory allocated by the search, see Memory.h
 } Algorithm;
 
-/* Breadth-First Search Implementation */
-Algorithm* BFS(Board* b_init, Board* b_goal) {
+/* Creates the result of a search before it starts: unsolved, without moves, path or bound */
+Algorithm* NewAlgorithm(void) {
     Algorithm* a_tmp = malloc(sizeof(Algorithm));
-    a_tmp->MovesPerformed = 0;
+    a_tmp->Solved = false;
     a_tmp->NodesVisited = 0;
+    a_tmp->MovesPerformed = 0;
+    a_tmp->ComputationTime = 0;
+    a_tmp->Bound = INFINITY;
+    a_tmp->path = NULL;
+    memset(&a_tmp->Memory, 0, sizeof(MemoryStats));
+    return a_tmp;
+}
+
+/** A thread running searches may point SearchStop at a flag that another thread raises to make them give up early,
+* e.g. when the daemon stops. The bounded searches check it with their node budget and return unsolved once it is set.
+*/
+_Thread_local atomic_bool const* SearchStop = NULL;
+
+/* Returns true once the searches of the calling thread must give up */
+bool IsSearchStopped(void) {
+    return SearchStop && atomic_load_explicit(SearchStop, memory_order_relaxed);
+}
+
+/** Returns true if the goal can never be reached from the initial board, in which case a search returns its result
+* from NewAlgorithm right away: boards with a different inversion parity than the goal can never reach it.
+*/
+bool RejectUnsolvable(Board const* b_init, Board const* b_goal) {
+    return !IsBoardSolvable(b_init, b_goal);
+}
+
+/* Breadth-First Search Implementation, giving up after visiting max_nodes nodes */
+Algorithm* BFS_Bounded(Board* b_init, Board* b_goal, unsigned int max_nodes) {
+    Algorithm* a_tmp = NewAlgorithm();
     NodeQueue* queue = NULL;
     NodeQueue* children = NULL;
     Node* node = NULL;
 
+    if (RejectUnsolvable(b_init, b_goal))
+        return a_tmp;
+
     // Begin computation timer
     clock_t c_timer_begin = clock();
+    MemoryAccount m_search;
+    MemoryBeginSearch(&m_search);
 
-    // Push the first node into the queue
-    PushNode(NewNode(0, b_init, NULL), &queue);
+    // Push the first node into the queue, the tree owns a copy of the initial board
+    Board* b_root = TrackedAlloc(MEMORY_BOARD, sizeof(Board));
+    *b_root = *b_init;
+    PushNode(NewNode(0, b_root, NULL), &queue);
     
     // Stored in order to deallocate the tree from memory later
     Node* n_root = queue->qn_head->n_current;
@@ -50,14 +92,15 @@ Algorithm* BFS(Board* b_init, Board* b_goal) {
 
         // BFS consumes a lot of memory, some random configurations are unsolvable with a given amount of memory.
         // If the the random configuration is impossible to solve given the amount of memory we have,
-        // end the program and try again
-        if (a_tmp->NodesVisited >= MAX_NODES) {
-            printf("The board is unsolvable with this configuration... Please try Again...");
-            exit(EXIT_FAILURE);
+        // stop searching and leave the result unsolved
+        if (a_tmp->NodesVisited >= max_nodes || IsSearchStopped()) {
+            break;
         }
 
         // Check if the tail node's board configuration is equal to the goal board
         if (AreBoardsEqual(node->board, b_goal)) {
+            a_tmp->Solved = true;
+            a_tmp->Bound = 1.0;
             break;
         }
         
@@ -76,12 +119,15 @@ Algorithm* BFS(Board* b_init, Board* b_goal) {
     // Get the ComputationTime in milliseconds
     a_tmp->ComputationTime = (double)(c_timer_end - c_timer_begin) / CLOCKS_PER_SEC;
 
-    // Get the path from the n_root node to the goal node
+    // Get the path from the n_root node to the goal node, the last node popped is not the goal if the budget ran out
     Path* p_head = NULL;
     Path* p_tmp = NULL;
 
+    if (!a_tmp->Solved)
+        node = NULL;
+
     while (node) {
-        p_tmp = malloc(sizeof(Path));
+        p_tmp = TrackedAlloc(MEMORY_PATH, sizeof(Path));
         p_tmp->move = node->board->move;
         p_tmp->next = p_head;
         p_head = p_tmp;
@@ -91,31 +137,53 @@ Algorithm* BFS(Board* b_init, Board* b_goal) {
     }
 
     // Remove the n_root node from the move counter
-    --a_tmp->MovesPerformed;
+    if (a_tmp->MovesPerformed > 0)
+        --a_tmp->MovesPerformed;
     
     // Set the final path to the member variable of the algorithm path
     a_tmp->path = p_head;
 
-    // Deallocate tree from memory
+    // Deallocate the remaining queue and the tree from memory
+    ClearQueue(&queue);
     FreeQueue(n_root);
+    MemoryEndSearch(&m_search, &a_tmp->Memory);
 
     return a_tmp;
 }
 
-/* Uniform-Cost Search Implementation */
-Algorithm* UCS(Board* b_init, Board* b_goal) {
-    Algorithm* a_tmp = malloc(sizeof(Algorithm));
-    a_tmp->MovesPerformed = 0;
-    a_tmp->NodesVisited = 0;
+/* Breadth-First Search Implementation */
+Algorithm* BFS(Board* b_init, Board* b_goal) {
+    Algorithm* a_tmp = BFS_Bounded(b_init, b_goal, MAX_NODES);
+
+    // If the the random configuration is impossible to solve given the amount of memory we have,
+    // end the program and try again
+    if (!a_tmp->Solved) {
+        printf("The board is unsolvable with this configuration... Please try Again...");
+        exit(EXIT_FAILURE);
+    }
+
+    return a_tmp;
+}
+
+/* Uniform-Cost Search Implementation, giving up after visiting max_nodes nodes */
+Algorithm* UCS_Bounded(Board* b_init, Board* b_goal, unsigned int max_nodes) {
+    Algorithm* a_tmp = NewAlgorithm();
     NodeQueue* queue = NULL;
     NodeQueue* children = NULL;
     Node* node = NULL;
 
+    if (RejectUnsolvable(b_init, b_goal))
+        return a_tmp;
+
     // Begin computation timer
     clock_t c_timer_begin = clock();
-    
-    // Push the first node into the queue
-    PushNode(NewNode(0, b_init, NULL), &queue);
+    MemoryAccount m_search;
+    MemoryBeginSearch(&m_search);
+
+    // Push the first node into the queue, the tree owns a copy of the initial board
+    Board* b_root = TrackedAlloc(MEMORY_BOARD, sizeof(Board));
+    *b_root = *b_init;
+    PushNode(NewNode(0, b_root, NULL), &queue);
 
     // Stored in order to deallocate the tree from memory later
     Node* n_root = queue->qn_head->n_current;
@@ -125,8 +193,15 @@ Algorithm* UCS(Board* b_init, Board* b_goal) {
         // Pop node from end of the queue
         node = PopNode(&queue);
 
+        // Stop searching once the node budget has been used up
+        if (a_tmp->NodesVisited >= max_nodes || IsSearchStopped()) {
+            break;
+        }
+
         // Check if the tail node's board configuration is equal to the goal board
         if (AreBoardsEqual(node->board, b_goal)) {
+            a_tmp->Solved = true;
+            a_tmp->Bound = 1.0;
             break;
         }
 
@@ -143,15 +218,18 @@ Algorithm* UCS(Board* b_init, Board* b_goal) {
     clock_t c_timer_end = clock();
 
     // Get the ComputationTime in seconds
-    a_tmp->ComputationTime = (c_timer_end - c_timer_begin) / (CLOCKS_PER_SEC);
+    a_tmp->ComputationTime = (double)(c_timer_end - c_timer_begin) / CLOCKS_PER_SEC;
 
-    // Get the path from the n_root node to the goal node
+    // Get the path from the n_root node to the goal node, the last node popped is not the goal if the budget ran out
     Path* p_head = NULL;
     Path* p_tmp = NULL;
 
+    if (!a_tmp->Solved)
+        node = NULL;
+
     // Iterate through the node and append relevant data
     while (node) {
-        p_tmp = malloc(sizeof(Path));
+        p_tmp = TrackedAlloc(MEMORY_PATH, sizeof(Path));
         p_tmp->move = node->board->move;
         p_tmp->next = p_head;
         p_head = p_tmp;
@@ -161,17 +239,25 @@ Algorithm* UCS(Board* b_init, Board* b_goal) {
     }
 
     // Remove the n_root node from the move counter
-    --a_tmp->MovesPerformed;
+    if (a_tmp->MovesPerformed > 0)
+        --a_tmp->MovesPerformed;
 
     // Set the final path to the member variable of the algorithm path
     a_tmp->path = p_head;
 
-    // Deallocate tree from memory
+    // Deallocate the remaining queue and the tree from memory
+    ClearQueue(&queue);
     FreeQueue(n_root);
+    MemoryEndSearch(&m_search, &a_tmp->Memory);
 
     return a_tmp;
 }
 
+/* Uniform-Cost Search Implementation */
+Algorithm* UCS(Board* b_init, Board* b_goal) {
+    return UCS_Bounded(b_init, b_goal, UINT_MAX);
+}
+
 /** Simulated Annealing Implementation **/
 double ManhattanDistance(Board* b, Board* b_goal) {
     double cost = 0;       // Total heuristic for given board
@@ -227,6 +313,9 @@ Node* NewNodeFromRandom(Node* n_curr) {
                 success = true;
                 break;
             }
+
+            // The move undoes the last one, try again
+            TrackedFree(MEMORY_BOARD, b_new, sizeof(Board));
         } else {
             continue;
         }
@@ -247,20 +336,25 @@ void LinearCooling(double* T, double T_step) {
 }
 
 Algorithm* SA(Board* b_init, Board* b_goal) {
-    Algorithm* a_tmp = malloc(sizeof(Algorithm));
-    a_tmp->MovesPerformed = 0;
-    a_tmp->NodesVisited = 0;
+    Algorithm* a_tmp = NewAlgorithm();
+
+    if (RejectUnsolvable(b_init, b_goal))
+        return a_tmp;
+
+    // Begin computation timer
+    clock_t c_timer_begin = clock();
+    MemoryAccount m_search;
+    MemoryBeginSearch(&m_search);
 
-    // Initial node based on the initial board configuration
-    Node* n_curr = NewNode(0, b_init, NULL);
+    // Initial node based on a copy of the initial board configuration
+    Board* b_root = TrackedAlloc(MEMORY_BOARD, sizeof(Board));
+    *b_root = *b_init;
+    Node* n_curr = NewNode(0, b_root, NULL);
     
     // List of nodes we will use in the end to display metrics
     NodeQueue* nq_final = NULL;
     PushNode(n_curr, &nq_final);
 
-    // Begin computation timer
-    clock_t c_timer_begin = clock();
-
     double T_max = 2.00;        // Our max temperature value
     double T_min = -2.00;       // Our min temperature value
     double T_step = 0.000001;   // Our 'Cooling Schedule'
@@ -269,6 +363,7 @@ Algorithm* SA(Board* b_init, Board* b_goal) {
 
         // Check if the current node's board configuration is equal to the goal board
         if (AreBoardsEqual(n_curr->board, b_goal)) {
+            a_tmp->Solved = true;
             break;
         }
 
@@ -296,6 +391,9 @@ Algorithm* SA(Board* b_init, Board* b_goal) {
             PushNode(n_new, &nq_final);
         }
         else {
+            // Deallocate the rejected node from memory
+            TrackedFree(MEMORY_BOARD, n_new->board, sizeof(Board));
+            TrackedFree(MEMORY_NODE, n_new, sizeof(Node));
             continue;
         }
     }
@@ -304,10 +402,25 @@ Algorithm* SA(Board* b_init, Board* b_goal) {
     clock_t c_timer_end = clock();
 
     // Get the ComputationTime in seconds
-    a_tmp->ComputationTime = (c_timer_end - c_timer_begin) / (CLOCKS_PER_SEC);
+    a_tmp->ComputationTime = (double)(c_timer_end - c_timer_begin) / CLOCKS_PER_SEC;
 
-    // Get the number of moves performed from the final queue of nodes
-    a_tmp->MovesPerformed = nq_final->n_count;
+    // Get the number of moves performed from the final queue of nodes, without the initial node
+    a_tmp->MovesPerformed = nq_final->n_count - 1;
+
+    // Get the path from the accepted nodes, the newest one is at the head of the queue
+    Path* p_tmp = NULL;
+    for (QueueNode* qn = nq_final->qn_head; qn; qn = qn->qn_next) {
+        p_tmp = TrackedAlloc(MEMORY_PATH, sizeof(Path));
+        p_tmp->move = qn->n_current->board->move;
+        p_tmp->next = a_tmp->path;
+        a_tmp->path = p_tmp;
+
+        // Deallocate the node from memory
+        TrackedFree(MEMORY_BOARD, qn->n_current->board, sizeof(Board));
+        TrackedFree(MEMORY_NODE, qn->n_current, sizeof(Node));
+    }
+    ClearQueue(&nq_final);
+    MemoryEndSearch(&m_search, &a_tmp->Memory);
 
     // Final Output
     printf("\n==== Results ====================================\n");
@@ -318,25 +431,38 @@ Algorithm* SA(Board* b_init, Board* b_goal) {
 }
 
 
-/* Prints a visual representation of the results of an algorithm */
-void PrintAlgorithm(Algorithm* algo) {
+/* Writes a visual representation of the results of an algorithm to a file */
+void FPrintAlgorithm(FILE* out, Algorithm const* algo) {
     // Create Whitespace
-    printf("\n");
+    fprintf(out, "\n");
     // Print Data
-    printf("Computation Time: %f Seconds\n", algo->ComputationTime);
-    printf("Nodes Visited: %i\n", algo->NodesVisited);
-    printf("== Moves Performed: %i ==========================\n", algo->MovesPerformed);
+    fprintf(out, "Computation Time: %f Seconds\n", algo->ComputationTime);
+    fprintf(out, "Nodes Visited: %i\n", algo->NodesVisited);
+    fprintf(out, "Suboptimality Bound: %f\n", algo->Bound);
+
+    if (!algo->Solved || !algo->path) {
+        fprintf(out, "== No Solution Found ============================\n");
+        fprintf(out, "=================================================\n");
+        return;
+    }
 
-    // Print Moves
+    fprintf(out, "== Moves Performed: %i ==========================\n", algo->MovesPerformed);
+
+    // Print Moves, skipping the initial board at the head of the path
     char* MoveStr[4] = { "ABOVE", "BELOW", "LEFT", "RIGHT" };
     int index = 1;
-    for (algo->path = algo->path->next; algo->path; algo->path = algo->path->next, ++index) {
-        if (algo->path->move == 0 || algo->path->move == 1)
-            printf("Move %i: Moved element from %s the empty space\n", index, MoveStr[algo->path->move]);
+    for (Path* p = algo->path->next; p; p = p->next, ++index) {
+        if (p->move == 0 || p->move == 1)
+            fprintf(out, "Move %i: Moved element from %s the empty space\n", index, MoveStr[p->move]);
         else
-            printf("Move %i: Moved element %s of the empty space\n", index, MoveStr[algo->path->move]);
+            fprintf(out, "Move %i: Moved element %s of the empty space\n", index, MoveStr[p->move]);
     }
-    printf("=================================================\n");
+    fprintf(out, "=================================================\n");
+}
+
+/* Prints a visual representation of the results of an algorithm */
+void PrintAlgorithm(Algorithm* algo) {
+    FPrintAlgorithm(stdout, algo);
 }
 
 void FreeAlgorithm(Algorithm** algo) {
@@ -346,7 +472,7 @@ void FreeAlgorithm(Algorithm** algo) {
         // Store next node in path
         p_next = (*algo)->path->next;
         // Deallocate from memory
-        free((*algo)->path);
+        TrackedFree(MEMORY_PATH, (*algo)->path, sizeof(Path));
         // Point to next node in path
         (*algo)->path = p_next;
     }
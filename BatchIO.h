@@ -0,0 +1,664 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Board.h"
+#include "Algorithm.h"
+
+#define BATCH_MAGIC "8PZBATCH"
+#define BATCH_VERSION 1
+
+/** Binary batch files
+* A versioned file of records, either boards to solve or solutions, for bulk pipelines:
+*
+*   [header][record 0][record 1]...[record n-1][index]
+*
+* Every record is a (length, CRC-32) pair followed by its payload, padded to 8 bytes so that it can be used in
+* place from a memory mapping. The index lists the offset of every record and is written when the writer is closed,
+* along with its checksum in the header. A file whose writer never closed has no index, its records are found by
+* scanning instead. Files can be reopened to append more records, the index is then rewritten at the new end.
+* All numbers are stored in the byte order of the machine (little-endian on every supported platform).
+*/
+
+/* The kind of records a batch file holds */
+typedef enum BatchRecordType { BATCH_BOARDS = 1, BATCH_SOLUTIONS = 2, } BatchRecordType;
+
+typedef struct BatchHeader {
+    char magic[8];              // BATCH_MAGIC, not null-terminated
+    uint16_t version;
+    uint16_t record_type;
+    uint32_t header_size;
+    uint64_t record_count;
+    uint64_t index_offset;      // 0 until the writer is closed
+    uint32_t index_checksum;
+    uint32_t header_checksum;   // CRC-32 of the header with this field set to 0
+    uint8_t reserved[24];
+} BatchHeader;
+
+typedef struct BatchRecordHeader {
+    uint32_t length;            // Length of the payload, without padding
+    uint32_t checksum;          // CRC-32 of the payload
+} BatchRecordHeader;
+
+/* Payload of a record of a BATCH_BOARDS file */
+typedef struct BatchBoardRecord {
+    uint64_t init;              // See PackBoard
+    uint64_t goal;
+} BatchBoardRecord;
+
+/* Payload of a record of a BATCH_SOLUTIONS file, the moves are packed 2 bits each starting at the lowest bits */
+typedef struct BatchSolutionRecord {
+    uint64_t init;
+    uint64_t goal;
+    uint32_t solved;
+    uint32_t moves_performed;
+    uint32_t nodes_visited;
+    uint32_t reserved;
+    double computation_time;
+    double bound;
+    uint8_t moves[];
+} BatchSolutionRecord;
+
+/* A batch file being written */
+typedef struct BatchWriter {
+    FILE* file;
+    BatchHeader header;
+    uint64_t end;               // Offset where the next record will be written
+    uint64_t* offsets;
+    size_t capacity;
+} BatchWriter;
+
+/* A batch file mapped into memory for reading */
+typedef struct BatchFile {
+    const uint8_t* data;
+    size_t size;
+    const BatchHeader* header;
+    const uint64_t* index;
+    uint64_t count;
+    uint64_t* scanned;          // Index built by scanning a file without one
+} BatchFile;
+
+/* CRC-32 (IEEE 802.3) of a buffer, continuing from a previous crc (0 to start) */
+uint32_t Crc32(const void* buf, size_t len, uint32_t crc) {
+    static uint32_t table[256];
+    static bool initialized = false;
+
+    if (!initialized) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        initialized = true;
+    }
+
+    const uint8_t* p = buf;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+uint32_t BatchHeaderChecksum(BatchHeader const* header) {
+    BatchHeader tmp = *header;
+    tmp.header_checksum = 0;
+    return Crc32(&tmp, sizeof(BatchHeader), 0);
+}
+
+/* Returns the size of a record in the file, including its header and padding */
+uint64_t BatchRecordSize(uint32_t length) {
+    return sizeof(BatchRecordHeader) + (((uint64_t)length + 7) & ~(uint64_t)7);
+}
+
+/* Returns the length of the smallest valid payload of a record of the given type */
+uint32_t BatchMinRecordLength(BatchRecordType type) {
+    return type == BATCH_BOARDS ? sizeof(BatchBoardRecord) : sizeof(BatchSolutionRecord);
+}
+
+/* Returns whether a header is a valid header of a file of the given size */
+bool IsBatchHeaderValid(BatchHeader const* header, size_t size) {
+    return memcmp(header->magic, BATCH_MAGIC, 8) == 0 && header->version == BATCH_VERSION
+        && header->header_size == sizeof(BatchHeader) && header->header_checksum == BatchHeaderChecksum(header)
+        && (header->record_type == BATCH_BOARDS || header->record_type == BATCH_SOLUTIONS)
+        && (header->index_offset == 0 || (header->index_offset <= size
+            && header->record_count <= (size - header->index_offset) / sizeof(uint64_t)));
+}
+
+/** Returns whether the index of a file with a valid header matches its checksum,
+* and every record it lists lies between the header and the index.
+*/
+bool IsBatchIndexValid(const uint8_t* data, BatchHeader const* header) {
+    const uint64_t* index = (const uint64_t*)(data + header->index_offset);
+    bool valid = header->index_offset % 8 == 0
+        && Crc32(index, header->record_count * sizeof(uint64_t), 0) == header->index_checksum;
+
+    for (uint64_t i = 0; i < header->record_count && valid; i++) {
+        BatchRecordHeader const* record = (BatchRecordHeader const*)(data + index[i]);
+        valid = index[i] >= sizeof(BatchHeader) && index[i] % 8 == 0
+            && index[i] + sizeof(BatchRecordHeader) <= header->index_offset
+            && BatchRecordSize(record->length) <= header->index_offset - index[i];
+    }
+
+    return valid;
+}
+
+/** Finds the records of a file without an index, stopping at the first truncated or corrupted one, or at the first
+* one too short for the type of records of the file (a zero-filled tail would otherwise pass as empty records).
+* Returns the offset following the last valid record.
+*/
+uint64_t ScanBatchRecords(const uint8_t* data, size_t size, BatchRecordType type, uint64_t** offsets, uint64_t* count,
+    size_t* capacity) {
+    uint64_t offset = sizeof(BatchHeader);
+    uint32_t min_length = BatchMinRecordLength(type);
+
+    while (offset + sizeof(BatchRecordHeader) <= size) {
+        BatchRecordHeader const* record = (BatchRecordHeader const*)(data + offset);
+        uint64_t record_size = BatchRecordSize(record->length);
+
+        if (record->length < min_length || record_size > size - offset || Crc32(record + 1, record->length, 0) != record->checksum)
+            break;
+
+        if (*count == *capacity) {
+            *capacity = *capacity ? *capacity * 2 : 1024;
+            *offsets = realloc(*offsets, *capacity * sizeof(uint64_t));
+        }
+        (*offsets)[(*count)++] = offset;
+        offset += record_size;
+    }
+
+    return offset;
+}
+
+/* Writes the header at the start of the file, keeping the current position */
+bool WriteBatchHeader(BatchWriter* w) {
+    long position = ftell(w->file);
+
+    w->header.header_checksum = BatchHeaderChecksum(&w->header);
+    return fseek(w->file, 0, SEEK_SET) == 0 && fwrite(&w->header, sizeof(BatchHeader), 1, w->file) == 1
+        && fseek(w->file, position, SEEK_SET) == 0;
+}
+
+/** Opens a batch file for writing.
+* If append is set and the file already holds records of the same type they are kept, otherwise the file is replaced.
+* Returns NULL if the file could not be opened, holds records of another type, or its header or index is corrupted.
+*/
+BatchWriter* NewBatchWriter(const char* path, BatchRecordType type, bool append) {
+    BatchWriter* w = calloc(1, sizeof(BatchWriter));
+    w->file = append ? fopen(path, "r+b") : NULL;
+
+    if (w->file) {
+        // Load the existing records from the file
+        BatchFile* existing = NULL;
+        struct stat st;
+        int fd = open(path, O_RDONLY);
+        if (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(BatchHeader)) {
+            void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                existing = calloc(1, sizeof(BatchFile));
+                existing->data = data;
+                existing->size = (size_t)st.st_size;
+            }
+        }
+        if (fd >= 0)
+            close(fd);
+
+        BatchHeader const* header = existing ? (BatchHeader const*)existing->data : NULL;
+        bool valid = header && IsBatchHeaderValid(header, existing->size) && header->record_type == type
+            && (header->index_offset == 0 || IsBatchIndexValid(existing->data, header));
+
+        if (valid) {
+            w->header = *(BatchHeader const*)existing->data;
+
+            if (w->header.index_offset != 0) {
+                // The new records replace the index
+                w->capacity = w->header.record_count ? w->header.record_count : 1;
+                w->offsets = malloc(w->capacity * sizeof(uint64_t));
+                memcpy(w->offsets, existing->data + w->header.index_offset, w->header.record_count * sizeof(uint64_t));
+                w->end = w->header.index_offset;
+            }
+            else {
+                w->header.record_count = 0;
+                w->end = ScanBatchRecords(existing->data, existing->size, type, &w->offsets, &w->header.record_count, &w->capacity);
+            }
+        }
+
+        if (existing) {
+            munmap((void*)existing->data, existing->size);
+            free(existing);
+        }
+
+        if (!valid) {
+            fclose(w->file);
+            free(w->offsets);
+            free(w);
+            return NULL;
+        }
+    }
+    else {
+        w->file = fopen(path, "w+b");
+        if (!w->file) {
+            free(w);
+            return NULL;
+        }
+
+        memcpy(w->header.magic, BATCH_MAGIC, 8);
+        w->header.version = BATCH_VERSION;
+        w->header.record_type = (uint16_t)type;
+        w->header.header_size = sizeof(BatchHeader);
+        w->end = sizeof(BatchHeader);
+    }
+
+    // Mark the file as not indexed while records are streamed into it
+    w->header.index_offset = 0;
+    w->header.index_checksum = 0;
+    if (fseek(w->file, (long)w->end, SEEK_SET) != 0 || !WriteBatchHeader(w)) {
+        fclose(w->file);
+        free(w->offsets);
+        free(w);
+        return NULL;
+    }
+
+    return w;
+}
+
+/* Appends a record with the given payload */
+bool AppendBatchRecord(BatchWriter* w, const void* payload, uint32_t length) {
+    static const uint8_t padding[8] = { 0 };
+    BatchRecordHeader record = { length, Crc32(payload, length, 0) };
+    uint64_t size = BatchRecordSize(length);
+
+    if (fwrite(&record, sizeof(record), 1, w->file) != 1 || fwrite(payload, 1, length, w->file) != length
+        || fwrite(padding, 1, size - sizeof(record) - length, w->file) != size - sizeof(record) - length) {
+        return false;
+    }
+
+    if (w->header.record_count == w->capacity) {
+        w->capacity = w->capacity ? w->capacity * 2 : 1024;
+        w->offsets = realloc(w->offsets, w->capacity * sizeof(uint64_t));
+    }
+    w->offsets[w->header.record_count++] = w->end;
+    w->end += size;
+
+    return true;
+}
+
+bool AppendBoardRecord(BatchWriter* w, Board const* b_init, Board const* b_goal) {
+    BatchBoardRecord record = { PackBoard(b_init), PackBoard(b_goal) };
+    return w->header.record_type == BATCH_BOARDS && AppendBatchRecord(w, &record, sizeof(record));
+}
+
+/* Appends the result of a search, packing its moves 2 bits each (none if it was not solved) */
+bool AppendSolutionRecord(BatchWriter* w, Board const* b_init, Board const* b_goal, Algorithm const* algo) {
+    if (w->header.record_type != BATCH_SOLUTIONS)
+        return false;
+
+    // Skip the initial board at the head of the path
+    Path* moves = algo->Solved && algo->path ? algo->path->next : NULL;
+    uint32_t n_moves = 0;
+    for (Path* p = moves; p; p = p->next) {
+        n_moves++;
+    }
+
+    uint32_t length = (uint32_t)(sizeof(BatchSolutionRecord) + (n_moves + 3) / 4);
+    BatchSolutionRecord* record = calloc(1, length);
+    record->init = PackBoard(b_init);
+    record->goal = PackBoard(b_goal);
+    record->solved = algo->Solved;
+    record->moves_performed = n_moves;
+    record->nodes_visited = algo->NodesVisited;
+    record->computation_time = algo->ComputationTime;
+    record->bound = algo->Bound;
+
+    uint32_t index = 0;
+    for (Path* p = moves; p; p = p->next, index++) {
+        record->moves[index / 4] |= (uint8_t)(p->move << (2 * (index % 4)));
+    }
+
+    bool success = AppendBatchRecord(w, record, length);
+    free(record);
+    return success;
+}
+
+/* Writes the index and the final header, then closes the file */
+bool CloseBatchWriter(BatchWriter** w) {
+    BatchWriter* bw = *w;
+    size_t index_size = bw->header.record_count * sizeof(uint64_t);
+
+    bw->header.index_offset = bw->end;
+    bw->header.index_checksum = Crc32(bw->offsets, index_size, 0);
+
+    bool success = fwrite(bw->offsets, 1, index_size, bw->file) == index_size && WriteBatchHeader(bw)
+        && fflush(bw->file) == 0 && ftruncate(fileno(bw->file), (off_t)(bw->end + index_size)) == 0;
+    success = fclose(bw->file) == 0 && success;
+
+    free(bw->offsets);
+    free(bw);
+    *w = NULL;
+
+    return success;
+}
+
+/** Maps a batch file into memory.
+* Returns NULL if the file could not be read or its header or index is corrupted.
+*/
+BatchFile* OpenBatchFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(BatchHeader))
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return NULL;
+
+    BatchFile* f = calloc(1, sizeof(BatchFile));
+    f->data = data;
+    f->size = (size_t)st.st_size;
+    f->header = data;
+
+    bool valid = IsBatchHeaderValid(f->header, f->size);
+    if (valid && f->header->index_offset != 0) {
+        f->index = (const uint64_t*)(f->data + f->header->index_offset);
+        f->count = f->header->record_count;
+        valid = IsBatchIndexValid(f->data, f->header);
+    }
+    else if (valid) {
+        size_t capacity = 0;
+        ScanBatchRecords(f->data, f->size, (BatchRecordType)f->header->record_type, &f->scanned, &f->count, &capacity);
+        f->index = f->scanned;
+    }
+
+    if (!valid) {
+        munmap((void*)f->data, f->size);
+        free(f);
+        return NULL;
+    }
+
+    return f;
+}
+
+void CloseBatchFile(BatchFile** f) {
+    munmap((void*)(*f)->data, (*f)->size);
+    free((*f)->scanned);
+    free(*f);
+    *f = NULL;
+}
+
+/* Returns a pointer to the payload of a record inside the mapping and its length, NULL if i is out of range */
+const void* GetBatchRecord(BatchFile const* f, uint64_t i, uint32_t* length) {
+    if (i >= f->count)
+        return NULL;
+
+    BatchRecordHeader const* record = (BatchRecordHeader const*)(f->data + f->index[i]);
+    if (length)
+        *length = record->length;
+
+    return record + 1;
+}
+
+/* Checks the CRC-32 of a record */
+bool VerifyBatchRecord(BatchFile const* f, uint64_t i) {
+    uint32_t length;
+    const void* payload = GetBatchRecord(f, i, &length);
+    return payload && Crc32(payload, length, 0) == ((BatchRecordHeader const*)payload - 1)->checksum;
+}
+
+BatchBoardRecord const* GetBoardRecord(BatchFile const* f, uint64_t i) {
+    uint32_t length;
+    const void* payload = GetBatchRecord(f, i, &length);
+    if (!payload || f->header->record_type != BATCH_BOARDS || length < sizeof(BatchBoardRecord))
+        return NULL;
+
+    return payload;
+}
+
+BatchSolutionRecord const* GetSolutionRecord(BatchFile const* f, uint64_t i) {
+    uint32_t length;
+    BatchSolutionRecord const* record = GetBatchRecord(f, i, &length);
+    if (!record || f->header->record_type != BATCH_SOLUTIONS || length < sizeof(BatchSolutionRecord)
+        || (length - sizeof(BatchSolutionRecord)) * 4 < record->moves_performed) {
+        return NULL;
+    }
+
+    return record;
+}
+
+/* Returns move i of a solution record */
+Move GetSolutionMove(BatchSolutionRecord const* record, uint32_t i) {
+    return (Move)((record->moves[i / 4] >> (2 * (i % 4))) & 3);
+}
+
+/* Rebuilds a search result (with the initial board at the head of its path, see BFS) from a solution record */
+Algorithm* NewAlgorithmFromRecord(BatchSolutionRecord const* record) {
+    Algorithm* a_tmp = malloc(sizeof(Algorithm));
+    a_tmp->Solved = record->solved != 0;
+    a_tmp->NodesVisited = record->nodes_visited;
+    a_tmp->MovesPerformed = record->moves_performed;
+    a_tmp->ComputationTime = record->computation_time;
+    a_tmp->Bound = record->bound;
+    a_tmp->path = NULL;
+    memset(&a_tmp->Memory, 0, sizeof(MemoryStats));
+
+    if (!a_tmp->Solved)
+        return a_tmp;
+
+    Path* p_tmp = NULL;
+    for (uint32_t i = record->moves_performed + 1; i-- > 0;) {
+        p_tmp = TrackedAlloc(MEMORY_PATH, sizeof(Path));
+        p_tmp->move = i > 0 ? GetSolutionMove(record, i - 1) : NONE;
+        p_tmp->next = a_tmp->path;
+        a_tmp->path = p_tmp;
+    }
+
+    return a_tmp;
+}
+
+/* The outcome of ReadBoard */
+typedef enum ReadStatus { READ_BOARD, READ_END, READ_MALFORMED, } ReadStatus;
+
+/** Reads a board in the format of PrintBoard.
+* Returns READ_END if the input ends before the opening line of another board, READ_MALFORMED if the board is cut
+* short or is not a permutation of the 9 cells.
+*/
+ReadStatus ReadBoard(FILE* in, Board* b) {
+    char line[64];
+    bool seen[9] = { false };
+
+    // Skip anything before the opening line
+    do {
+        if (!fgets(line, sizeof(line), in))
+            return READ_END;
+    } while (strncmp(line, "===", 3) != 0);
+
+    for (int i = 0; i < 3; i++) {
+        if (!fgets(line, sizeof(line), in))
+            return READ_MALFORMED;
+
+        for (int j = 0; j < 3; j++) {
+            int value = line[j] == ' ' ? 0 : line[j] - '0';
+            if (value < 0 || value > 8 || seen[value])
+                return READ_MALFORMED;
+
+            seen[value] = true;
+            b->config[i][j] = value;
+        }
+    }
+
+    b->move = NONE;
+    return fgets(line, sizeof(line), in) && strncmp(line, "===", 3) == 0 ? READ_BOARD : READ_MALFORMED;
+}
+
+/** Reads the initial and goal boards of a record in the text format of BatchToText.
+* Returns READ_END at the end of the input, READ_MALFORMED if either board is malformed or the goal is missing.
+*/
+ReadStatus ReadBoardPair(FILE* in, Board* b_init, Board* b_goal) {
+    ReadStatus status = ReadBoard(in, b_init);
+    if (status != READ_BOARD)
+        return status;
+
+    return ReadBoard(in, b_goal) == READ_BOARD ? READ_BOARD : READ_MALFORMED;
+}
+
+/** Converts pairs of initial and goal boards in the format of PrintBoard to a BATCH_BOARDS file.
+* Returns the number of records written, or -1 if the file could not be written or the text holds a malformed board
+* (the records before it are still written).
+*/
+long BoardsTextToBatch(FILE* in, const char* path, bool append) {
+    BatchWriter* w = NewBatchWriter(path, BATCH_BOARDS, append);
+    if (!w)
+        return -1;
+
+    Board b_init, b_goal;
+    long count = 0;
+    bool success = true;
+    ReadStatus status;
+    while (success && (status = ReadBoardPair(in, &b_init, &b_goal)) == READ_BOARD) {
+        success = AppendBoardRecord(w, &b_init, &b_goal);
+        count++;
+    }
+
+    return CloseBatchWriter(&w) && success && status == READ_END ? count : -1;
+}
+
+/** Converts solutions in the text format written by BatchToText to a BATCH_SOLUTIONS file.
+* Returns the number of records written, or -1 if the file could not be written or the text holds a malformed board
+* (the records before it are still written).
+*/
+long SolutionsTextToBatch(FILE* in, const char* path, bool append) {
+    BatchWriter* w = NewBatchWriter(path, BATCH_SOLUTIONS, append);
+    if (!w)
+        return -1;
+
+    char* MoveStr[4] = { "ABOVE", "BELOW", "LEFT", "RIGHT" };
+    char line[256];
+    Board b_init, b_goal;
+    long count = 0;
+    bool success = true;
+    ReadStatus status;
+
+    while (success && (status = ReadBoardPair(in, &b_init, &b_goal)) == READ_BOARD) {
+        Algorithm algo = { .Solved = false, .Bound = INFINITY };
+        Path* p_tail = TrackedAlloc(MEMORY_PATH, sizeof(Path));
+        p_tail->move = NONE;
+        p_tail->next = NULL;
+        algo.path = p_tail;
+
+        // Read the lines of PrintAlgorithm until its closing line
+        while (fgets(line, sizeof(line), in)) {
+            if (strncmp(line, "Computation Time:", 17) == 0) {
+                algo.ComputationTime = strtod(line + 17, NULL);
+            }
+            else if (strncmp(line, "Nodes Visited:", 14) == 0) {
+                algo.NodesVisited = (unsigned int)strtoul(line + 14, NULL, 10);
+            }
+            else if (strncmp(line, "Suboptimality Bound:", 20) == 0) {
+                algo.Bound = strtod(line + 20, NULL);
+            }
+            else if (strncmp(line, "== Moves Performed:", 19) == 0) {
+                algo.Solved = true;
+            }
+            else if (strncmp(line, "Move ", 5) == 0) {
+                for (int m = 0; m < 4; m++) {
+                    if (strstr(line, MoveStr[m])) {
+                        p_tail->next = TrackedAlloc(MEMORY_PATH, sizeof(Path));
+                        p_tail = p_tail->next;
+                        p_tail->move = (Move)m;
+                        p_tail->next = NULL;
+                        algo.MovesPerformed++;
+                        break;
+                    }
+                }
+            }
+            else if (strncmp(line, "=====", 5) == 0) {
+                break;
+            }
+        }
+
+        success = AppendSolutionRecord(w, &b_init, &b_goal, &algo);
+        count++;
+
+        // Deallocate the path from memory
+        Path* p_next;
+        for (Path* p = algo.path; p; p = p_next) {
+            p_next = p->next;
+            TrackedFree(MEMORY_PATH, p, sizeof(Path));
+        }
+    }
+
+    return CloseBatchWriter(&w) && success && status == READ_END ? count : -1;
+}
+
+/** Writes every record of a batch file as text: the boards in the format of PrintBoard,
+* followed by the result in the format of PrintAlgorithm for solutions. Returns false if the file could not be read.
+* Records failing their CRC-32 or holding an invalid board are skipped and counted in corrupted (if not NULL).
+*/
+bool BatchToText(const char* path, FILE* out, uint64_t* corrupted) {
+    BatchFile* f = OpenBatchFile(path);
+    if (!f)
+        return false;
+
+    if (corrupted)
+        *corrupted = 0;
+
+    Board b_init, b_goal;
+    for (uint64_t i = 0; i < f->count; i++) {
+        uint64_t init = 0, goal = 0;
+        BatchSolutionRecord const* solution = NULL;
+        bool readable;
+
+        if (f->header->record_type == BATCH_BOARDS) {
+            BatchBoardRecord const* record = GetBoardRecord(f, i);
+            readable = record != NULL;
+            if (readable) {
+                init = record->init;
+                goal = record->goal;
+            }
+        }
+        else {
+            solution = GetSolutionRecord(f, i);
+            readable = solution != NULL;
+            if (readable) {
+                init = solution->init;
+                goal = solution->goal;
+            }
+        }
+
+        if (!readable || !VerifyBatchRecord(f, i) || !IsPackedBoardValid(init) || !IsPackedBoardValid(goal)) {
+            if (corrupted)
+                (*corrupted)++;
+            continue;
+        }
+
+        UnpackBoard(init, &b_init);
+        UnpackBoard(goal, &b_goal);
+        fprintf(out, "- Initial Board Configuration -\n");
+        FPrintBoard(out, &b_init);
+        fprintf(out, "- Goal Configuration -\n");
+        FPrintBoard(out, &b_goal);
+
+        if (solution) {
+            Algorithm* algo = NewAlgorithmFromRecord(solution);
+            FPrintAlgorithm(out, algo);
+            FreeAlgorithm(&algo);
+        }
+    }
+
+    CloseBatchFile(&f);
+    return true;
+}
@@ -0,0 +1,356 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+#include "Board.h"
+#include "Algorithm.h"
+#include "Frontier.h"
+
+#define WEIGHT_SCALE 1000   // Fixed-point scale of weighted priorities
+#define MAX_WEIGHT 100000.0 // Highest w, keeps (g + w * h) * WEIGHT_SCALE within an unsigned int
+#define BEAM_MAX_WIDTH 181440 // Number of boards reachable from a board, no layer of a beam can hold more
+
+/** Bounded-suboptimal best-first searches
+* A family of fast searches sharing one frontier (see Frontier.h), trading path length for speed:
+*   * Weighted A*: expands the board with the lowest g + w * h, the path is at most w times the optimal one.
+*   * Focal search: expands, among the boards whose f = g + h is at most w times the lowest f, the one closest
+*     to the goal, with the same guarantee as weighted A*.
+*   * Greedy best-first: expands the board closest to the goal (lowest h), without any guarantee.
+*   * Beam search: a breadth-first search keeping only the width boards closest to the goal in each layer,
+*     so memory grows with the width of the beam instead of the size of the search space.
+*
+* Every open board is also kept in a list ordered by f. Boards are reopened when a shorter path to them is found,
+* so the lowest f of that list is a lower bound on the optimal number of moves, and the bound actually achieved
+* (moves performed / lower bound) is reported in Algorithm, usually well below w.
+*/
+
+/* The search strategy used by the frontier */
+typedef enum FrontierMode {
+    FRONTIER_WEIGHTED,
+    FRONTIER_FOCAL,
+    FRONTIER_GREEDY,
+    FRONTIER_BEAM,
+} FrontierMode;
+
+/* The state of a bounded-suboptimal search */
+typedef struct BestFirstSearch {
+    FrontierMode mode;
+    double weight;
+
+    uint64_t goal;
+    int goal_pos[9];
+
+    StateTable table;
+    OpenHeap open;      // Ordered by the priority of the mode, the focal list ordered by h for focal search
+    OpenHeap open_f;    // Every open board ordered by f, its minimum bounds the optimal number of moves
+    OpenHeap waiting;   // Open boards not part of the focal list yet, ordered by f (focal search only)
+    unsigned int f_min; // Lowest f of the open boards when the last board was selected (focal search only)
+} BestFirstSearch;
+
+/* A child board that may be kept in the next layer of a beam search */
+typedef struct BeamCandidate {
+    uint64_t state;
+    uint64_t parent;
+    unsigned int h;
+    Move move;
+} BeamCandidate;
+
+/* Returns whether an item of one of the open lists still refers to an open board */
+bool IsOpenItem(BestFirstSearch* s, OpenItem const* item) {
+    StateEntry* e = StateTableFind(&s->table, item->state);
+    return e->state == item->state && !e->closed && e->g == item->g;
+}
+
+/* Records a path to a board, (re)opening it if the path is the shortest one found so far */
+void BestFirstOpen(BestFirstSearch* s, uint64_t state, uint64_t parent, unsigned int g, Move move) {
+    bool inserted;
+    StateEntry* e = StateTableInsert(&s->table, state, &inserted);
+    if (!inserted && e->g <= g)
+        return;
+
+    e->parent = parent;
+    e->g = g;
+    e->move = move;
+    e->closed = false;
+    e->focal = false;
+
+    unsigned int h = PackedManhattanDistance(state, s->goal_pos);
+    OpenItem item_f = { g + h, g, state };
+    OpenHeapPush(&s->open_f, item_f);
+
+    if (s->mode == FRONTIER_FOCAL) {
+        // The lowest f never decreases with a consistent heuristic, so the board stays eligible once it is
+        if (g + h <= s->weight * s->f_min) {
+            e->focal = true;
+            OpenItem item = { h, g, state };
+            OpenHeapPush(&s->open, item);
+        }
+        else {
+            OpenHeapPush(&s->waiting, item_f);
+        }
+    }
+    else {
+        unsigned int key = h;
+        if (s->mode == FRONTIER_WEIGHTED)
+            key = (unsigned int)((g + s->weight * h) * WEIGHT_SCALE + 0.5);
+
+        OpenItem item = { key, g, state };
+        OpenHeapPush(&s->open, item);
+    }
+}
+
+/* Returns the lowest f of the open boards, UINT_MAX if there are none */
+unsigned int BestFirstMinF(BestFirstSearch* s) {
+    while (s->open_f.count > 0 && !IsOpenItem(s, &s->open_f.items[0])) {
+        OpenHeapPop(&s->open_f);
+    }
+
+    return s->open_f.count > 0 ? s->open_f.items[0].key : UINT_MAX;
+}
+
+/* Selects the next board to expand, returns false if there are no open boards left */
+bool BestFirstSelect(BestFirstSearch* s, OpenItem* item) {
+    if (s->mode == FRONTIER_FOCAL) {
+        s->f_min = BestFirstMinF(s);
+        if (s->f_min == UINT_MAX)
+            return false;
+
+        // Move the boards that became eligible into the focal list
+        while (s->waiting.count > 0 && s->waiting.items[0].key <= s->weight * s->f_min) {
+            OpenItem waiting = OpenHeapPop(&s->waiting);
+            StateEntry* e = StateTableFind(&s->table, waiting.state);
+
+            if (IsOpenItem(s, &waiting) && !e->focal) {
+                e->focal = true;
+                OpenItem focal = { waiting.key - waiting.g, waiting.g, waiting.state };
+                OpenHeapPush(&s->open, focal);
+            }
+        }
+    }
+
+    while (s->open.count > 0) {
+        *item = OpenHeapPop(&s->open);
+        if (IsOpenItem(s, item))
+            return true;
+    }
+
+    return false;
+}
+
+int CompareBeamCandidates(const void* a, const void* b) {
+    BeamCandidate const* x = a;
+    BeamCandidate const* y = b;
+
+    if (x->h != y->h)
+        return (x->h > y->h) - (x->h < y->h);
+    return (x->state > y->state) - (x->state < y->state);
+}
+
+/* Beam search over the frontier table, the table only ever holds the boards kept in the beam */
+void BeamSearch_Layers(BestFirstSearch* s, Algorithm* a_tmp, uint64_t init, unsigned int width, unsigned int max_nodes) {
+    size_t layer_size = width * sizeof(uint64_t);
+    size_t candidates_size = 4 * (size_t)width * sizeof(BeamCandidate);
+    uint64_t* layer = TrackedAlloc(MEMORY_OPEN_LIST, layer_size);
+    uint64_t* next = TrackedAlloc(MEMORY_OPEN_LIST, layer_size);
+    BeamCandidate* candidates = TrackedAlloc(MEMORY_OPEN_LIST, candidates_size);
+    size_t n_layer = 1;
+    bool pruned = false;
+
+    // Give up without searching if the beam does not fit in memory
+    if (!layer || !next || !candidates) {
+        TrackedFree(MEMORY_OPEN_LIST, candidates, candidates_size);
+        TrackedFree(MEMORY_OPEN_LIST, next, layer_size);
+        TrackedFree(MEMORY_OPEN_LIST, layer, layer_size);
+        return;
+    }
+
+    layer[0] = init;
+
+    for (unsigned int depth = 0; n_layer > 0 && !a_tmp->Solved; depth++) {
+        size_t n_candidates = 0;
+
+        // Generate the children of the layer that were never part of the beam
+        for (size_t i = 0; i < n_layer; i++) {
+            if (a_tmp->NodesVisited >= max_nodes || IsSearchStopped()) {
+                n_layer = 0;
+                break;
+            }
+            a_tmp->NodesVisited++;
+
+            int blank = PackedBlankIndex(layer[i]);
+            for (Move move = ABOVE; move <= RIGHT; move++) {
+                uint64_t child = PackedApplyMove(layer[i], blank, move);
+                if (child == 0 || StateTableFind(&s->table, child)->state == child)
+                    continue;
+
+                BeamCandidate c = { child, layer[i], PackedManhattanDistance(child, s->goal_pos), move };
+                candidates[n_candidates++] = c;
+            }
+        }
+
+        // Keep the width children closest to the goal
+        qsort(candidates, n_candidates, sizeof(BeamCandidate), CompareBeamCandidates);
+
+        size_t n_next = 0;
+        for (size_t i = 0; i < n_candidates; i++) {
+            if (n_next == width) {
+                pruned = true;
+                break;
+            }
+
+            bool inserted;
+            StateEntry* e = StateTableInsert(&s->table, candidates[i].state, &inserted);
+            if (!inserted)
+                continue;
+
+            e->parent = candidates[i].parent;
+            e->g = depth + 1;
+            e->move = candidates[i].move;
+            next[n_next++] = candidates[i].state;
+
+            if (candidates[i].state == s->goal) {
+                a_tmp->Solved = true;
+                a_tmp->MovesPerformed = depth + 1;
+                break;
+            }
+        }
+
+        uint64_t* tmp = layer;
+        layer = next;
+        next = tmp;
+        n_layer = n_next;
+    }
+
+    // Without pruning, the beam is a breadth-first search and the path is optimal
+    if (a_tmp->Solved && !pruned)
+        a_tmp->Bound = 1.0;
+
+    TrackedFree(MEMORY_OPEN_LIST, candidates, candidates_size);
+    TrackedFree(MEMORY_OPEN_LIST, next, layer_size);
+    TrackedFree(MEMORY_OPEN_LIST, layer, layer_size);
+}
+
+/** Bounded-Suboptimal Best-First Search Implementation
+* weight is the w of weighted A* and focal search (clamped to 1..MAX_WEIGHT, a larger w already expands boards
+* in the order of greedy search), width is the width of a beam search (clamped to 1..BEAM_MAX_WIDTH).
+* Gives up after expanding max_nodes boards.
+*/
+Algorithm* BoundedBestFirst(Board* b_init, Board* b_goal, FrontierMode mode, double weight, unsigned int width,
+    unsigned int max_nodes) {
+    Algorithm* a_tmp = NewAlgorithm();
+
+    if (RejectUnsolvable(b_init, b_goal))
+        return a_tmp;
+
+    // Begin computation timer
+    clock_t c_timer_begin = clock();
+    MemoryAccount m_search;
+    MemoryBeginSearch(&m_search);
+
+    BestFirstSearch s = { 0 };
+    s.mode = mode;
+    s.weight = weight >= 1.0 ? fmin(weight, MAX_WEIGHT) : 1.0;
+    s.goal = PackBoard(b_goal);
+    GetGoalPositions(b_goal, s.goal_pos);
+
+    uint64_t init = PackBoard(b_init);
+
+    if (mode == FRONTIER_BEAM) {
+        bool inserted;
+        StateEntry* e = StateTableInsert(&s.table, init, &inserted);
+        e->parent = 0;
+        e->g = 0;
+        e->move = NONE;
+
+        if (init == s.goal) {
+            a_tmp->Solved = true;
+            a_tmp->Bound = 1.0;
+        }
+        else {
+            BeamSearch_Layers(&s, a_tmp, init, width < 1 ? 1 : width > BEAM_MAX_WIDTH ? BEAM_MAX_WIDTH : width, max_nodes);
+        }
+    }
+    else {
+        BestFirstOpen(&s, init, 0, 0, NONE);
+
+        unsigned int lower = 0;
+        OpenItem item;
+        while (BestFirstSelect(&s, &item)) {
+            if (a_tmp->NodesVisited >= max_nodes || IsSearchStopped())
+                break;
+
+            if (item.state == s.goal) {
+                a_tmp->Solved = true;
+                lower = BestFirstMinF(&s);
+                break;
+            }
+
+            StateEntry* e = StateTableFind(&s.table, item.state);
+            uint64_t parent = e->parent;
+            e->closed = true;
+            a_tmp->NodesVisited++;
+
+            int blank = PackedBlankIndex(item.state);
+            for (Move move = ABOVE; move <= RIGHT; move++) {
+                uint64_t child = PackedApplyMove(item.state, blank, move);
+                if (child != 0 && child != parent)
+                    BestFirstOpen(&s, child, item.state, item.g + 1, move);
+            }
+        }
+
+        if (a_tmp->Solved) {
+            // Ancestors of the goal reopened after its g was recorded shorten the parent links, so the path followed
+            // from the goal can be shorter than that g: count the moves of the path itself
+            a_tmp->path = StateTablePath(&s.table, s.goal);
+            for (Path* p = a_tmp->path->next; p; p = p->next) {
+                a_tmp->MovesPerformed++;
+            }
+
+            // The lower bound was taken while the goal was still open, so it is at most the optimal number of moves
+            a_tmp->Bound = lower > 0 ? (double)a_tmp->MovesPerformed / lower : 1.0;
+        }
+    }
+
+    // End computation timer
+    clock_t c_timer_end = clock();
+
+    // Get the ComputationTime in seconds
+    a_tmp->ComputationTime = (double)(c_timer_end - c_timer_begin) / CLOCKS_PER_SEC;
+
+    if (a_tmp->Solved && !a_tmp->path)
+        a_tmp->path = StateTablePath(&s.table, s.goal);
+
+    FreeStateTable(&s.table);
+    FreeOpenHeap(&s.open);
+    FreeOpenHeap(&s.open_f);
+    FreeOpenHeap(&s.waiting);
+    MemoryEndSearch(&m_search, &a_tmp->Memory);
+
+    return a_tmp;
+}
+
+/* Weighted A* Implementation, the path is at most weight times longer than the optimal one */
+Algorithm* WeightedAStar(Board* b_init, Board* b_goal, double weight) {
+    return BoundedBestFirst(b_init, b_goal, FRONTIER_WEIGHTED, weight, 0, UINT_MAX);
+}
+
+/* Focal Search Implementation, the path is at most weight times longer than the optimal one */
+Algorithm* FocalSearch(Board* b_init, Board* b_goal, double weight) {
+    return BoundedBestFirst(b_init, b_goal, FRONTIER_FOCAL, weight, 0, UINT_MAX);
+}
+
+/* Greedy Best-First Search Implementation */
+Algorithm* GreedyBestFirst(Board* b_init, Board* b_goal) {
+    return BoundedBestFirst(b_init, b_goal, FRONTIER_GREEDY, 1.0, 0, UINT_MAX);
+}
+
+/* Beam Search Implementation, keeping the width most promising boards of each layer */
+Algorithm* BeamSearch(Board* b_init, Board* b_goal, unsigned int width) {
+    return BoundedBestFirst(b_init, b_goal, FRONTIER_BEAM, 1.0, width, UINT_MAX);
+}
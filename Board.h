@@ -1,11 +1,17 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
-/* The list of available moves relevant to the empty space. */
-typedef enum Move { ABOVE, BELOW, LEFT, RIGHT, } Move;
+#include "Memory.h"
+
+/* The list of available moves relevant to the empty space.
+* NONE marks a board that was not created by a move (e.g. the initial board).
+*/
+typedef enum Move { ABOVE, BELOW, LEFT, RIGHT, NONE, } Move;
 
 /* The data-structure representing a board configuration. 
 * It also contains an enum representing the last move used to create this configuration.
@@ -17,31 +23,76 @@ typedef struct Board {
 } Board;
 
 void PrintMove(Board* b) {
-    char* MoveStr[4] = { "ABOVE", "BELOW", "LEFT", "RIGHT" };
+    char* MoveStr[5] = { "ABOVE", "BELOW", "LEFT", "RIGHT", "NONE" };
     printf("Move: %s\n", MoveStr[b->move]);
 }
 
-// Randomly shuffle an array representing the board configuration
+// Draw a random number in [0, n) from rand(), rejecting the values that would make the low numbers more likely
+int RandBelow(int n) {
+    unsigned long range = (unsigned long)RAND_MAX + 1;
+    unsigned long limit = range - range % (unsigned long)n;
+    unsigned long r;
+
+    do {
+        r = (unsigned long)rand();
+    } while (r >= limit);
+
+    return (int)(r % (unsigned long)n);
+}
+
+// Randomly shuffle an array representing the board configuration (Fisher-Yates)
 void ShuffleBoard(int* arr) {
-    for (int i = 0; i < 9 - 0; i++) {
-        size_t j = i + rand() / (RAND_MAX / (9 - i) + 0);
+    for (int i = 0; i < 9 - 1; i++) {
+        int j = i + RandBelow(9 - i);
         int t = arr[j];
         arr[j] = arr[i];
         arr[i] = t;
     }
 }
 
+/* Returns the parity of the number of inversions among the 9 cells of a board, ignoring the empty space */
+int InversionParity(int const* cells) {
+    int inversions = 0;
+    for (int i = 0; i < 9; i++) {
+        for (int j = i + 1; j < 9; j++) {
+            if (cells[i] && cells[j] && cells[i] > cells[j])
+                inversions++;
+        }
+    }
+
+    return inversions % 2;
+}
+
+/** Makes an arrangement solvable towards the goal arrangement by swapping two tiles if needed.
+* Every move of the empty space keeps the inversion parity of a 3x3 board, so a board can only reach the goal
+* if both have the same parity. Swapping two tiles flips the parity and pairs every unsolvable arrangement
+* with exactly one solvable one, so uniformly shuffled arrangements stay uniform among the solvable ones.
+*/
+void MakeSolvable(int* cells, int const* goal) {
+    if (InversionParity(cells) == InversionParity(goal))
+        return;
+
+    // Swap the first two tiles
+    int a = cells[0] ? 0 : 1;
+    int b = cells[a + 1] ? a + 1 : a + 2;
+    int t = cells[a];
+    cells[a] = cells[b];
+    cells[b] = t;
+}
+
 /* Create a new board with a random initial configuration */
 void NewBoard(Board* b, bool isGoal, bool isRandom) {
     int initArr[] = { 2, 8, 3, 1, 6, 4, 7, 0, 5 };
     int goalArr[] = { 1, 2, 3, 8, 0, 4, 7, 6, 5 };
 
-    // Randomly shuffle the initial configuration
+    // Randomly shuffle the initial configuration, keeping it solvable
     if (isRandom) {
         ShuffleBoard(initArr);
+        MakeSolvable(initArr, goalArr);
     }
 
     // Populate spaces in board.
+    b->move = NONE;
     int a = 0;
     for (int i = 0; i < 3; i++) {
         for (int j = 0; j < 3; j++) {
@@ -55,7 +106,7 @@ void NewBoard(Board* b, bool isGoal, bool isRandom) {
 
 /* Create a new board configuration if the proposed move is valid. */
 Board* NewBoardIfValid(Board* b_parent, Move move) {
-    Board* b_tmp = malloc(sizeof(Board));
+    Board* b_tmp = TrackedAlloc(MEMORY_BOARD, sizeof(Board));
 
     int e_row, e_col; 
     
@@ -104,24 +155,34 @@ Board* NewBoardIfValid(Board* b_parent, Move move) {
 
     // If the proposed move does not result in a valid board configuration,
     // deallocate memory and return NULL
-    free(b_tmp);
+    TrackedFree(MEMORY_BOARD, b_tmp, sizeof(Board));
     return NULL;
 }
 
-void PrintBoard(Board* b) {
-    printf("===\n");
+/* Writes a visual representation of a board to a file */
+void FPrintBoard(FILE* out, Board const* b) {
+    fprintf(out, "===\n");
     for (int i = 0; i < 3; ++i) {
         for (int j = 0; j < 3; ++j) {
             if (b->config[i][j] == 0) {
-                printf(" ");
+                fprintf(out, " ");
                 continue;
             }
 
-            printf("%i", b->config[i][j]);
+            fprintf(out, "%i", b->config[i][j]);
         }
-        printf("\n");
+        fprintf(out, "\n");
     }
-    printf("===\n");
+    fprintf(out, "===\n");
+}
+
+void PrintBoard(Board* b) {
+    FPrintBoard(stdout, b);
+}
+
+/* Returns whether the goal can be reached from a board, in constant time (see MakeSolvable) */
+bool IsBoardSolvable(Board const* b, Board const* b_goal) {
+    return InversionParity(&b->config[0][0]) == InversionParity(&b_goal->config[0][0]);
 }
 
 bool AreBoardsEqual(Board const* b_1, Board const* b_2) {
@@ -133,4 +194,113 @@ bool AreBoardsEqual(Board const* b_1, Board const* b_2) {
     }
     
     return true;
-}
\ No newline at end of file
+}
+
+/* Packs a board configuration into 4 bits per cell, row by row, starting at the lowest bits */
+uint64_t PackBoard(Board const* b) {
+    uint64_t packed = 0;
+    for (int i = 0; i < 9; i++) {
+        packed |= (uint64_t)b->config[i / 3][i % 3] << (4 * i);
+    }
+
+    return packed;
+}
+
+/* Unpacks a configuration created by PackBoard into a board */
+void UnpackBoard(uint64_t packed, Board* b) {
+    b->move = NONE;
+    for (int i = 0; i < 9; i++) {
+        b->config[i / 3][i % 3] = (int)((packed >> (4 * i)) & 0xF);
+    }
+}
+
+/* Returns whether a packed configuration holds each of the tiles 0-8 exactly once, see PackBoard */
+bool IsPackedBoardValid(uint64_t packed) {
+    unsigned int seen = 0;
+    for (int i = 0; i < 9; i++) {
+        seen |= 1u << ((packed >> (4 * i)) & 0xF);
+    }
+
+    return seen == 0x1FF && (packed >> 36) == 0;
+}
+
+/** Parses a board from a string of 9 digits listed row by row, using 0 for the empty space (e.g. "283164705").
+* Returns false if the string is not a permutation of the digits 0-8.
+*/
+bool NewBoardFromString(Board* b, const char* str) {
+    bool seen[9] = { false };
+
+    for (int i = 0; i < 9; i++) {
+        if (str[i] < '0' || str[i] > '8' || seen[str[i] - '0'])
+            return false;
+
+        seen[str[i] - '0'] = true;
+        b->config[i / 3][i % 3] = str[i] - '0';
+    }
+
+    b->move = NONE;
+    return str[9] == '\0';
+}
+
+/* Writes a board as a string of 9 digits, the inverse of NewBoardFromString. str must hold 10 characters. */
+void BoardToString(Board const* b, char* str) {
+    for (int i = 0; i < 9; i++) {
+        str[i] = (char)('0' + b->config[i / 3][i % 3]);
+    }
+    str[9] = '\0';
+}
+
+/* Returns the index (row * 3 + column) of the empty space of a packed board */
+int PackedBlankIndex(uint64_t packed) {
+    for (int i = 0; i < 9; i++) {
+        if (((packed >> (4 * i)) & 0xF) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+/** Applies a move to a packed board whose empty space is at index blank.
+* Returns 0 (which is never a valid packed board) if the move would leave the grid.
+*/
+uint64_t PackedApplyMove(uint64_t packed, int blank, Move move) {
+    int target;
+
+    // Find the cell that will be swapped with the empty space
+    if (move == ABOVE && blank >= 3)
+        target = blank - 3;
+    else if (move == BELOW && blank < 6)
+        target = blank + 3;
+    else if (move == LEFT && blank % 3 > 0)
+        target = blank - 1;
+    else if (move == RIGHT && blank % 3 < 2)
+        target = blank + 1;
+    else
+        return 0;
+
+    // Move the tile into the empty space, leaving its old cell empty
+    uint64_t tile = (packed >> (4 * target)) & 0xF;
+    return (packed & ~((uint64_t)0xF << (4 * target))) | (tile << (4 * blank));
+}
+
+/* Fills goal_pos with the index (row * 3 + column) of every tile in the goal board */
+void GetGoalPositions(Board const* b_goal, int goal_pos[9]) {
+    for (int i = 0; i < 9; i++) {
+        goal_pos[b_goal->config[i / 3][i % 3]] = i;
+    }
+}
+
+/* Manhattan Distance of a packed board, ignoring the empty space so that it never overestimates */
+unsigned int PackedManhattanDistance(uint64_t packed, int const goal_pos[9]) {
+    unsigned int cost = 0;
+
+    for (int i = 0; i < 9; i++) {
+        int tile = (int)((packed >> (4 * i)) & 0xF);
+        if (tile == 0)
+            continue;
+
+        cost += abs(i / 3 - goal_pos[tile] / 3) + abs(i % 3 - goal_pos[tile] % 3);
+    }
+
+    return cost;
+}
@@ -0,0 +1,774 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "Board.h"
+#include "Algorithm.h"
+#include "BestFirst.h"
+#include "IDAStar.h"
+#include "Transposition.h"
+
+#define DAEMON_CACHE_SIZE 4096      // Number of cached solutions, must be a power of two
+#define DAEMON_MAX_CLIENTS 64       // Max number of simultaneous socket connections
+#define DAEMON_LINE_MAX 2048        // Max length of a single request or response line
+#define DAEMON_MAX_MOVES 1024       // Max length of a cached move sequence
+#define DAEMON_WORKERS 4            // Number of threads running searches
+#define DAEMON_TT_BYTES (8 << 20)   // Size of the transposition table of each worker
+#define DAEMON_OUTPUT_MAX (1 << 20) // Max size of the answers waiting for a client to read them
+#define DAEMON_MAX_BUDGET 1000000   // Max node budget of a request, about 200 MB for the UCS solver
+
+/** The solver daemon answers solve requests over a line protocol, either on stdin/stdout or a Unix-domain socket.
+* Every request starts with a client chosen id which is echoed back in its response, so clients can pipeline
+* any number of requests without waiting for the previous answers:
+*
+*   <id> SOLVE <solver> <budget> <initial> <goal>  ->  <id> OK <moves> <nodes> <seconds> <bound> <path>
+*                                                  ->  <id> FAIL <nodes>   (budget exhausted)
+*                                                  ->  <id> UNSOLVABLE     (goal unreachable)
+*   <id> STATS                                     ->  <id> STATS key=value ...
+*   <id> SHUTDOWN                                  ->  <id> BYE
+*
+* The solver is one of BFS, UCS, IDA (IDA* with a transposition table), WA:<w> (weighted A*), FOCAL:<w>,
+* BEAM:<width> or GREEDY (see BestFirst.h).
+* Boards are 9 digits row by row with 0 as the empty space (see NewBoardFromString), budget is the max number of
+* nodes to visit (at most DAEMON_MAX_BUDGET), bound is the proven ratio to the optimal number of moves ("inf" if there is none) and the path
+* is a string of U/D/L/R moves ("-" if the initial board is the goal).
+*
+* Searches run on a pool of DAEMON_WORKERS threads, so a long search never holds up other requests. Answers are
+* written as soon as they are ready, which is not necessarily the order of the requests, and are matched to them
+* by id. Requests that need no search (errors, cached solutions, STATS) are answered right away.
+* Answers are buffered for each client and written without blocking; a client that lets more than
+* DAEMON_OUTPUT_MAX bytes of answers pile up is disconnected. SHUTDOWN drops the answers of searches still running,
+* and stops them (see SearchStop) instead of waiting for their budget to run out.
+*
+* Between requests the daemon keeps a cache of solutions, and every worker keeps its transposition table warm
+* for the IDA solver. Searches running at once on different workers count their memory separately (see Memory.h).
+*/
+
+/* The solvers that can be requested from the daemon */
+typedef enum Solver {
+    SOLVER_BFS, SOLVER_UCS, SOLVER_IDA, SOLVER_WEIGHTED, SOLVER_FOCAL, SOLVER_BEAM, SOLVER_GREEDY,
+} Solver;
+
+/* A solution kept warm between requests */
+typedef struct CachedSolution {
+    bool valid;
+    Solver solver;
+    double param;
+    uint64_t init;
+    uint64_t goal;
+
+    unsigned int NodesVisited;
+    unsigned int MovesPerformed;
+    double ComputationTime;
+    double Bound;
+    char moves[DAEMON_MAX_MOVES + 1];
+} CachedSolution;
+
+/* Counters reported by the STATS request */
+typedef struct DaemonStats {
+    unsigned long Requests;
+    unsigned long Solves;
+    unsigned long CacheHits;
+    unsigned long Failures;
+    unsigned long Unsolvable;
+    unsigned long Errors;
+    unsigned long NodesVisited;
+    double ComputationTime;
+    size_t PeakBytes;           // Highest peak memory of a single search, see Memory.h
+} DaemonStats;
+
+/* A search handed to the workers, and its result */
+typedef struct DaemonJob {
+    struct DaemonJob* next;
+    unsigned long client;       // Serial number of the connection that sent the request
+    char id[32];
+    Solver solver;
+    double param;
+    unsigned int budget;
+    Board b_init;
+    Board b_goal;
+    Algorithm* algo;            // Set by the worker
+} DaemonJob;
+
+typedef struct Daemon Daemon;
+
+/* A thread running searches */
+typedef struct DaemonWorker {
+    pthread_t thread;
+    Daemon* daemon;
+    TranspositionTable* tt;     // Kept warm between the IDA searches of this worker
+} DaemonWorker;
+
+/* The state kept alive for the lifetime of the daemon, everything but the job lists is owned by the main thread */
+struct Daemon {
+    bool running;
+    time_t started;
+    DaemonStats stats;
+    CachedSolution* cache;
+    unsigned int in_flight;     // Jobs queued or running
+
+    pthread_mutex_t lock;       // Protects the job lists and stopping
+    pthread_cond_t wake;        // Signaled when a job is queued or the workers must stop
+    bool stopping;
+    atomic_bool cancel;         // Makes the running searches give up, see SearchStop
+    DaemonJob* queued_head;     // Waiting for a worker, oldest first
+    DaemonJob* queued_tail;
+    DaemonJob* done;            // Finished, waiting to be answered
+    int notify[2];              // Pipe written by the workers when a job is done
+
+    unsigned int n_workers;
+    DaemonWorker* workers;
+};
+
+/* Runs the search requested by a job */
+Algorithm* RunSolver(DaemonJob* job, TranspositionTable* tt) {
+    switch (job->solver) {
+    case SOLVER_BFS:
+        return BFS_Bounded(&job->b_init, &job->b_goal, job->budget);
+    case SOLVER_UCS:
+        return UCS_Bounded(&job->b_init, &job->b_goal, job->budget);
+    case SOLVER_IDA:
+        return IDAStar_Bounded(&job->b_init, &job->b_goal, tt, job->budget);
+    case SOLVER_WEIGHTED:
+        return BoundedBestFirst(&job->b_init, &job->b_goal, FRONTIER_WEIGHTED, job->param, 0, job->budget);
+    case SOLVER_FOCAL:
+        return BoundedBestFirst(&job->b_init, &job->b_goal, FRONTIER_FOCAL, job->param, 0, job->budget);
+    case SOLVER_BEAM:
+        return BoundedBestFirst(&job->b_init, &job->b_goal, FRONTIER_BEAM, 1.0, (unsigned int)job->param, job->budget);
+    case SOLVER_GREEDY:
+    default:
+        return BoundedBestFirst(&job->b_init, &job->b_goal, FRONTIER_GREEDY, 1.0, 0, job->budget);
+    }
+}
+
+/* Takes queued jobs and runs them until the daemon stops */
+void* DaemonWorkerRun(void* arg) {
+    DaemonWorker* w = arg;
+    Daemon* d = w->daemon;
+    SearchStop = &d->cancel;
+
+    pthread_mutex_lock(&d->lock);
+    while (true) {
+        while (!d->stopping && !d->queued_head) {
+            pthread_cond_wait(&d->wake, &d->lock);
+        }
+        if (d->stopping)
+            break;
+
+        DaemonJob* job = d->queued_head;
+        d->queued_head = job->next;
+        if (!d->queued_head)
+            d->queued_tail = NULL;
+        pthread_mutex_unlock(&d->lock);
+
+        job->algo = RunSolver(job, w->tt);
+
+        pthread_mutex_lock(&d->lock);
+        job->next = d->done;
+        d->done = job;
+
+        // A full pipe already holds a wakeup
+        ssize_t written = write(d->notify[1], "", 1);
+        (void)written;
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    return NULL;
+}
+
+/* Creates a new daemon with an empty solution cache and starts its workers */
+Daemon* NewDaemon(void) {
+    Daemon* d = malloc(sizeof(Daemon));
+    d->running = true;
+    d->started = time(NULL);
+    memset(&d->stats, 0, sizeof(DaemonStats));
+    d->cache = calloc(DAEMON_CACHE_SIZE, sizeof(CachedSolution));
+    d->in_flight = 0;
+
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->wake, NULL);
+    d->stopping = false;
+    atomic_init(&d->cancel, false);
+    d->queued_head = NULL;
+    d->queued_tail = NULL;
+    d->done = NULL;
+
+    if (pipe(d->notify) == 0) {
+        fcntl(d->notify[0], F_SETFL, fcntl(d->notify[0], F_GETFL) | O_NONBLOCK);
+        fcntl(d->notify[1], F_SETFL, fcntl(d->notify[1], F_GETFL) | O_NONBLOCK);
+    }
+    else {
+        d->notify[0] = -1;
+        d->notify[1] = -1;
+    }
+
+    d->n_workers = DAEMON_WORKERS;
+    d->workers = calloc(d->n_workers, sizeof(DaemonWorker));
+    for (unsigned int i = 0; i < d->n_workers; i++) {
+        d->workers[i].daemon = d;
+        d->workers[i].tt = NewTranspositionTable(DAEMON_TT_BYTES, REPLACE_SHALLOWER);
+        pthread_create(&d->workers[i].thread, NULL, DaemonWorkerRun, &d->workers[i]);
+    }
+
+    return d;
+}
+
+void FreeJobs(DaemonJob* job) {
+    DaemonJob* next;
+    for (; job; job = next) {
+        next = job->next;
+        if (job->algo)
+            FreeAlgorithm(&job->algo);
+        free(job);
+    }
+}
+
+/* Stops the workers, making the searches they are running give up, and frees the daemon */
+void FreeDaemon(Daemon** d) {
+    Daemon* dm = *d;
+
+    atomic_store_explicit(&dm->cancel, true, memory_order_relaxed);
+    pthread_mutex_lock(&dm->lock);
+    dm->stopping = true;
+    pthread_cond_broadcast(&dm->wake);
+    pthread_mutex_unlock(&dm->lock);
+
+    for (unsigned int i = 0; i < dm->n_workers; i++) {
+        pthread_join(dm->workers[i].thread, NULL);
+        FreeTranspositionTable(&dm->workers[i].tt);
+    }
+    free(dm->workers);
+
+    FreeJobs(dm->queued_head);
+    FreeJobs(dm->done);
+    if (dm->notify[0] >= 0) {
+        close(dm->notify[0]);
+        close(dm->notify[1]);
+    }
+    pthread_cond_destroy(&dm->wake);
+    pthread_mutex_destroy(&dm->lock);
+
+    free(dm->cache);
+    free(dm);
+    *d = NULL;
+}
+
+/* Returns the cache slot of a solve request */
+CachedSolution* GetCacheSlot(Daemon* d, Solver solver, uint64_t init, uint64_t goal) {
+    // Mix both boards into a single hash (splitmix64 finalizer)
+    return &d->cache[HashState(init * 31 + goal + solver) & (DAEMON_CACHE_SIZE - 1)];
+}
+
+/* Writes the moves of a solved algorithm as a string of U/D/L/R characters, skipping the initial board */
+bool PathToString(Algorithm* algo, char* str, size_t len) {
+    char MoveChr[4] = { 'U', 'D', 'L', 'R' };
+    size_t index = 0;
+
+    for (Path* p = algo->path ? algo->path->next : NULL; p; p = p->next) {
+        if (index + 1 >= len)
+            return false;
+        str[index++] = MoveChr[p->move];
+    }
+    str[index] = '\0';
+
+    return true;
+}
+
+/** Answers a SOLVE request from the cache, or queues its search for the workers.
+* Returns the queued job, whose answer comes later from CompleteSolve, or NULL if the answer was written to out.
+*/
+DaemonJob* HandleSolve(Daemon* d, unsigned long client, const char* id, char* args, char* out, size_t out_len) {
+    char s_solver[32], s_init[16], s_goal[16];
+    unsigned int budget;
+    Board b_init, b_goal;
+    Solver solver;
+    double param = 0;
+
+    if (sscanf(args, "%31s %u %15s %15s", s_solver, &budget, s_init, s_goal) != 4) {
+        d->stats.Errors++;
+        snprintf(out, out_len, "%s ERR usage: SOLVE <solver> <budget> <initial> <goal>\n", id);
+        return NULL;
+    }
+
+    // Split the parameter of the solver, e.g. WA:1.5
+    char* s_param = strchr(s_solver, ':');
+    if (s_param) {
+        *s_param++ = '\0';
+        param = strtod(s_param, NULL);
+    }
+
+    if (!isfinite(param)) {
+        d->stats.Errors++;
+        snprintf(out, out_len, "%s ERR solver parameter must be a finite number\n", id);
+        return NULL;
+    }
+
+    if (strcmp(s_solver, "BFS") == 0) {
+        solver = SOLVER_BFS;
+    }
+    else if (strcmp(s_solver, "UCS") == 0) {
+        solver = SOLVER_UCS;
+    }
+    else if (strcmp(s_solver, "IDA") == 0) {
+        solver = SOLVER_IDA;
+    }
+    else if (strcmp(s_solver, "WA") == 0 && param >= 1.0) {
+        solver = SOLVER_WEIGHTED;
+        param = fmin(param, MAX_WEIGHT);
+    }
+    else if (strcmp(s_solver, "FOCAL") == 0 && param >= 1.0) {
+        solver = SOLVER_FOCAL;
+        param = fmin(param, MAX_WEIGHT);
+    }
+    else if (strcmp(s_solver, "BEAM") == 0 && param >= 1.0) {
+        solver = SOLVER_BEAM;
+        param = floor(fmin(param, BEAM_MAX_WIDTH));
+    }
+    else if (strcmp(s_solver, "GREEDY") == 0) {
+        solver = SOLVER_GREEDY;
+    }
+    else {
+        d->stats.Errors++;
+        snprintf(out, out_len, "%s ERR unknown solver %s\n", id, s_solver);
+        return NULL;
+    }
+
+    if (budget > DAEMON_MAX_BUDGET) {
+        d->stats.Errors++;
+        snprintf(out, out_len, "%s ERR budget must be at most %u\n", id, DAEMON_MAX_BUDGET);
+        return NULL;
+    }
+
+    if (!NewBoardFromString(&b_init, s_init) || !NewBoardFromString(&b_goal, s_goal)) {
+        d->stats.Errors++;
+        snprintf(out, out_len, "%s ERR boards must be permutations of 012345678\n", id);
+        return NULL;
+    }
+
+    d->stats.Solves++;
+
+    // Reject unreachable goals before searching
+    if (!IsBoardSolvable(&b_init, &b_goal)) {
+        d->stats.Unsolvable++;
+        snprintf(out, out_len, "%s UNSOLVABLE\n", id);
+        return NULL;
+    }
+
+    uint64_t init = PackBoard(&b_init);
+    uint64_t goal = PackBoard(&b_goal);
+    CachedSolution* slot = GetCacheSlot(d, solver, init, goal);
+
+    // Searches are deterministic, so a cached solution found after visiting fewer nodes than the budget
+    // is exactly what a fresh search would return, and one that needed more nodes means the search would fail.
+    // IDA depends on the state of the transposition table, its cached node count is the one of the first search.
+    if (slot->valid && slot->solver == solver && slot->param == param && slot->init == init && slot->goal == goal) {
+        d->stats.CacheHits++;
+
+        if (slot->NodesVisited >= budget) {
+            d->stats.Failures++;
+            snprintf(out, out_len, "%s FAIL %u\n", id, budget);
+        }
+        else {
+            snprintf(out, out_len, "%s OK %u %u %f %f %s\n", id, slot->MovesPerformed, slot->NodesVisited,
+                slot->ComputationTime, slot->Bound, slot->MovesPerformed ? slot->moves : "-");
+        }
+        return NULL;
+    }
+
+    DaemonJob* job = calloc(1, sizeof(DaemonJob));
+    job->client = client;
+    snprintf(job->id, sizeof(job->id), "%s", id);
+    job->solver = solver;
+    job->param = param;
+    job->budget = budget;
+    job->b_init = b_init;
+    job->b_goal = b_goal;
+
+    // Hand the search to the workers
+    pthread_mutex_lock(&d->lock);
+    if (d->queued_tail)
+        d->queued_tail->next = job;
+    else
+        d->queued_head = job;
+    d->queued_tail = job;
+    pthread_cond_signal(&d->wake);
+    pthread_mutex_unlock(&d->lock);
+    d->in_flight++;
+
+    return job;
+}
+
+/* Writes the answer of a finished search into out, keeping its solution warm for later requests */
+void CompleteSolve(Daemon* d, DaemonJob* job, char* out, size_t out_len) {
+    Algorithm* algo = job->algo;
+
+    d->in_flight--;
+    d->stats.NodesVisited += algo->NodesVisited;
+    d->stats.ComputationTime += algo->ComputationTime;
+    if (algo->Memory.Total.PeakBytes > d->stats.PeakBytes)
+        d->stats.PeakBytes = algo->Memory.Total.PeakBytes;
+
+    if (!algo->Solved) {
+        d->stats.Failures++;
+        snprintf(out, out_len, "%s FAIL %u\n", job->id, algo->NodesVisited);
+        return;
+    }
+
+    uint64_t init = PackBoard(&job->b_init);
+    uint64_t goal = PackBoard(&job->b_goal);
+    CachedSolution* slot = GetCacheSlot(d, job->solver, init, goal);
+
+    if (PathToString(algo, slot->moves, sizeof(slot->moves))) {
+        slot->valid = true;
+        slot->solver = job->solver;
+        slot->param = job->param;
+        slot->init = init;
+        slot->goal = goal;
+        slot->NodesVisited = algo->NodesVisited;
+        slot->MovesPerformed = algo->MovesPerformed;
+        slot->ComputationTime = algo->ComputationTime;
+        slot->Bound = algo->Bound;
+
+        snprintf(out, out_len, "%s OK %u %u %f %f %s\n", job->id, slot->MovesPerformed, slot->NodesVisited,
+            slot->ComputationTime, slot->Bound, slot->MovesPerformed ? slot->moves : "-");
+    }
+    else {
+        slot->valid = false;
+        d->stats.Errors++;
+        snprintf(out, out_len, "%s ERR path longer than %d moves\n", job->id, DAEMON_MAX_MOVES);
+    }
+}
+
+/** Answers a single request line from a client, writing the response line into out.
+* Returns the job queued for a SOLVE request that needs a search, whose answer comes later.
+*/
+DaemonJob* HandleRequest(Daemon* d, unsigned long client, char* line, char* out, size_t out_len) {
+    char id[32], command[16];
+    int consumed = 0;
+
+    out[0] = '\0';
+
+    // Ignore empty lines
+    if (sscanf(line, "%31s %15s %n", id, command, &consumed) < 2) {
+        if (sscanf(line, "%31s", id) == 1) {
+            d->stats.Errors++;
+            snprintf(out, out_len, "%s ERR missing command\n", id);
+        }
+        return NULL;
+    }
+
+    d->stats.Requests++;
+
+    if (strcmp(command, "SOLVE") == 0) {
+        return HandleSolve(d, client, id, line + consumed, out, out_len);
+    }
+    else if (strcmp(command, "STATS") == 0) {
+        snprintf(out, out_len,
+            "%s STATS uptime=%ld requests=%lu solves=%lu cache_hits=%lu failures=%lu unsolvable=%lu errors=%lu nodes_visited=%lu computation_time=%f"
+            " peak_bytes=%zu in_flight=%u\n",
+            id, (long)(time(NULL) - d->started), d->stats.Requests, d->stats.Solves, d->stats.CacheHits,
+            d->stats.Failures, d->stats.Unsolvable, d->stats.Errors, d->stats.NodesVisited, d->stats.ComputationTime,
+            d->stats.PeakBytes, d->in_flight);
+    }
+    else if (strcmp(command, "SHUTDOWN") == 0) {
+        d->running = false;
+        snprintf(out, out_len, "%s BYE\n", id);
+    }
+    else {
+        d->stats.Errors++;
+        snprintf(out, out_len, "%s ERR unknown command %s\n", id, command);
+    }
+
+    return NULL;
+}
+
+/* Writes the whole buffer to a file descriptor, waiting until it can be written */
+bool WriteAll(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd p = { fd, POLLOUT, 0 };
+                poll(&p, 1, -1);
+                continue;
+            }
+            return false;
+        }
+        buf += written;
+        len -= (size_t)written;
+    }
+
+    return true;
+}
+
+/* A connection to the daemon, the partial request line received from it and the answers not written yet */
+typedef struct DaemonClient {
+    int in_fd;
+    int out_fd;                 // Same as in_fd for a socket
+    int out_flags;              // File status flags of out_fd before it was made non-blocking
+    unsigned long serial;
+    bool closing;               // No more requests will be read, removed once every answer is written
+    bool failed;                // Could not be written to, removed right away
+    unsigned int pending;       // Searches still running for the client
+
+    size_t len;
+    char buffer[DAEMON_LINE_MAX];
+
+    char* output;
+    size_t out_len;
+    size_t out_cap;
+} DaemonClient;
+
+/* Buffers an answer for a client, dropping the client if it does not read its answers */
+void ClientQueue(DaemonClient* c, const char* response) {
+    size_t len = strlen(response);
+    if (c->failed || len == 0)
+        return;
+
+    if (c->out_len + len > DAEMON_OUTPUT_MAX) {
+        c->failed = true;
+        return;
+    }
+
+    if (c->out_len + len > c->out_cap) {
+        c->out_cap = c->out_cap ? c->out_cap * 2 : DAEMON_LINE_MAX;
+        while (c->out_cap < c->out_len + len) {
+            c->out_cap *= 2;
+        }
+        c->output = realloc(c->output, c->out_cap);
+    }
+
+    memcpy(c->output + c->out_len, response, len);
+    c->out_len += len;
+}
+
+/* Writes as much of the buffered answers of a client as possible without blocking */
+void ClientFlush(DaemonClient* c) {
+    size_t written = 0;
+
+    while (written < c->out_len && !c->failed) {
+        ssize_t n = write(c->out_fd, c->output + written, c->out_len - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                c->failed = true;
+            break;
+        }
+        written += (size_t)n;
+    }
+
+    c->out_len -= written;
+    memmove(c->output, c->output + written, c->out_len);
+}
+
+/* Reads the requests received from a client, queuing searches and buffering the immediate answers */
+void ClientRead(Daemon* d, DaemonClient* c) {
+    char response[DAEMON_LINE_MAX];
+    ssize_t received = read(c->in_fd, c->buffer + c->len, sizeof(c->buffer) - 1 - c->len);
+
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return;
+    if (received <= 0) {
+        c->closing = true;
+        return;
+    }
+
+    c->len += (size_t)received;
+    c->buffer[c->len] = '\0';
+
+    // Answer every complete line received so far
+    char* line = c->buffer;
+    char* newline;
+    while (d->running && (newline = strchr(line, '\n'))) {
+        *newline = '\0';
+        if (HandleRequest(d, c->serial, line, response, sizeof(response)))
+            c->pending++;
+        ClientQueue(c, response);
+        line = newline + 1;
+    }
+
+    // Keep the partial line for the next read, dropping lines that are too long
+    c->len -= (size_t)(line - c->buffer);
+    memmove(c->buffer, line, c->len);
+    if (c->len == sizeof(c->buffer) - 1) {
+        c->len = 0;
+    }
+}
+
+void AddClient(DaemonClient* clients, unsigned int* n_clients, int in_fd, int out_fd, unsigned long serial) {
+    DaemonClient* c = &clients[(*n_clients)++];
+    memset(c, 0, sizeof(DaemonClient));
+    c->in_fd = in_fd;
+    c->out_fd = out_fd;
+    c->serial = serial;
+    c->out_flags = fcntl(out_fd, F_GETFL);
+    fcntl(out_fd, F_SETFL, c->out_flags | O_NONBLOCK);
+}
+
+/* Closes a connection, restoring its output to blocking mode (it may be shared, as stdout is) */
+void RemoveClient(DaemonClient* c, bool is_socket) {
+    fcntl(c->out_fd, F_SETFL, c->out_flags);
+    if (is_socket)
+        close(c->in_fd);
+    free(c->output);
+}
+
+/** Serves requests from the clients accepted on listener (-1 for none) and from the connection in_fd/out_fd
+* (-1 for none) until SHUTDOWN, or until the connection is closed and answered when there is no listener.
+*/
+void ServeConnections(Daemon* d, int listener, int in_fd, int out_fd) {
+    DaemonClient* clients = calloc(DAEMON_MAX_CLIENTS, sizeof(DaemonClient));
+    unsigned int n_clients = 0;
+    unsigned long serial = 0;
+
+    // Closed connections are noticed through write errors
+    signal(SIGPIPE, SIG_IGN);
+
+    if (in_fd >= 0)
+        AddClient(clients, &n_clients, in_fd, out_fd, serial++);
+
+    // The poll entries are the notification pipe, the listener, then the input and output of the clients
+    struct pollfd fds[2 * DAEMON_MAX_CLIENTS + 2];
+    int owner[2 * DAEMON_MAX_CLIENTS + 2];
+    char response[DAEMON_LINE_MAX];
+
+    while (d->running && (listener >= 0 || n_clients > 0)) {
+        nfds_t n_fds = 0;
+        fds[n_fds].fd = d->notify[0];
+        fds[n_fds++].events = POLLIN;
+        fds[n_fds].fd = n_clients < DAEMON_MAX_CLIENTS ? listener : -1;
+        fds[n_fds++].events = POLLIN;
+
+        for (unsigned int i = 0; i < n_clients; i++) {
+            if (!clients[i].closing) {
+                owner[n_fds] = (int)i;
+                fds[n_fds].fd = clients[i].in_fd;
+                fds[n_fds++].events = POLLIN;
+            }
+            if (clients[i].out_len > 0) {
+                owner[n_fds] = (int)i;
+                fds[n_fds].fd = clients[i].out_fd;
+                fds[n_fds++].events = POLLOUT;
+            }
+        }
+
+        if (poll(fds, n_fds, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        for (nfds_t i = 2; i < n_fds && d->running; i++) {
+            DaemonClient* c = &clients[owner[i]];
+            if (fds[i].events == POLLIN && (fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                ClientRead(d, c);
+            else if (fds[i].events == POLLOUT && (fds[i].revents & (POLLHUP | POLLERR)))
+                c->failed = true;
+        }
+
+        // Answer the finished searches
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(d->notify[0], drain, sizeof(drain)) > 0) {
+            }
+
+            pthread_mutex_lock(&d->lock);
+            DaemonJob* done = d->done;
+            d->done = NULL;
+            pthread_mutex_unlock(&d->lock);
+
+            for (DaemonJob* job = done; job; job = job->next) {
+                CompleteSolve(d, job, response, sizeof(response));
+
+                // The client may have disconnected in the meantime
+                for (unsigned int i = 0; i < n_clients; i++) {
+                    if (clients[i].serial == job->client) {
+                        clients[i].pending--;
+                        ClientQueue(&clients[i], response);
+                        break;
+                    }
+                }
+            }
+            FreeJobs(done);
+        }
+
+        // Accept new connections
+        if (fds[1].fd >= 0 && (fds[1].revents & POLLIN)) {
+            int fd = accept(listener, NULL, NULL);
+            if (fd >= 0)
+                AddClient(clients, &n_clients, fd, fd, serial++);
+        }
+
+        // Write the answers, removing the connections that are done by moving the last one into their place
+        for (unsigned int i = 0; i < n_clients; i++) {
+            DaemonClient* c = &clients[i];
+            if (c->out_len > 0)
+                ClientFlush(c);
+
+            if (c->failed || (c->closing && c->out_len == 0 && c->pending == 0)) {
+                RemoveClient(c, listener >= 0);
+                clients[i--] = clients[--n_clients];
+            }
+        }
+    }
+
+    // Write the last answers (the BYE of SHUTDOWN) before closing
+    for (unsigned int i = 0; i < n_clients; i++) {
+        if (!clients[i].failed)
+            WriteAll(clients[i].out_fd, clients[i].output, clients[i].out_len);
+        RemoveClient(&clients[i], listener >= 0);
+    }
+    free(clients);
+}
+
+/* Serves requests read line by line from in until SHUTDOWN or end of input */
+void RunDaemon(Daemon* d, FILE* in, FILE* out) {
+    fflush(out);
+    ServeConnections(d, -1, fileno(in), fileno(out));
+}
+
+/** Serves requests on a Unix-domain socket at the given path until SHUTDOWN.
+* Any number of clients may be connected at once and each may pipeline its requests.
+* Returns false if the socket could not be created.
+*/
+bool RunDaemonSocket(Daemon* d, const char* path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return false;
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        return false;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, DAEMON_MAX_CLIENTS) < 0) {
+        close(listener);
+        return false;
+    }
+
+    ServeConnections(d, listener, -1, -1);
+
+    close(listener);
+    unlink(path);
+
+    return true;
+}
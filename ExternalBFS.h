@@ -0,0 +1,457 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Board.h"
+
+#define EBFS_IO_STATES 8192     // Number of states buffered by each reader and writer
+#define EBFS_PATH_MAX 512       // Max length of a layer or run file path
+#define EBFS_MERGE_FAN_IN 16    // Max number of runs merged at once, bounding the number of open files
+
+/** External-Memory Breadth-First Search
+* Instead of keeping every node in memory, each layer (all states at the same distance from the initial board) is
+* stored on disk as a sorted file of packed boards. The next layer is generated by streaming through the current
+* one: children are collected in a fixed-size buffer which is sorted and written out as a run whenever it fills up.
+* The runs are then merged, dropping duplicates and any state already in the current or previous layer (moves are
+* reversible, so a child can only appear in those layers or in the next one).
+* When there are more runs than EBFS_MERGE_FAN_IN they are first merged in groups into longer runs, so only a
+* bounded number of files is open at once.
+* Only the child buffer and a few I/O buffers are kept in memory, whatever the size of the state space.
+*/
+
+/* The layer statistics and goal distance computed by an external-memory BFS */
+typedef struct ExternalBFS {
+    bool Solved;                // Whether the goal was reached
+    unsigned int GoalDistance;  // Exact number of moves from the initial board to the goal
+    unsigned int Layers;        // Number of layers generated
+    uint64_t* LayerSizes;       // Number of distinct states at each depth
+    uint64_t StatesVisited;
+    double ComputationTime;
+} ExternalBFS;
+
+/* Buffered sequential reader of a file of packed boards */
+typedef struct StateReader {
+    FILE* file;
+    uint64_t current;
+    bool valid;         // False once the end of the file is reached
+    size_t pos;
+    size_t len;
+    uint64_t buffer[EBFS_IO_STATES];
+} StateReader;
+
+/* Buffered sequential writer of a file of packed boards */
+typedef struct StateWriter {
+    FILE* file;
+    uint64_t count;
+    size_t len;
+    uint64_t buffer[EBFS_IO_STATES];
+} StateWriter;
+
+/* Moves the reader to the next state, marking it invalid at the end of the file */
+void ReaderNext(StateReader* r) {
+    if (r->pos == r->len) {
+        r->len = r->file ? fread(r->buffer, sizeof(uint64_t), EBFS_IO_STATES, r->file) : 0;
+        r->pos = 0;
+    }
+
+    r->valid = r->pos < r->len;
+    if (r->valid)
+        r->current = r->buffer[r->pos++];
+}
+
+/** Opens a reader on its first state, a NULL path reads as empty.
+* Returns NULL if the file could not be opened.
+*/
+StateReader* NewStateReader(const char* path) {
+    FILE* file = NULL;
+    if (path && !(file = fopen(path, "rb")))
+        return NULL;
+
+    StateReader* r = malloc(sizeof(StateReader));
+    r->file = file;
+    r->pos = 0;
+    r->len = 0;
+    ReaderNext(r);
+    return r;
+}
+
+void FreeStateReader(StateReader** r) {
+    if ((*r)->file)
+        fclose((*r)->file);
+    free(*r);
+    *r = NULL;
+}
+
+/* Advances the reader until its current state is at least state, returns whether it is equal */
+bool ReaderSkipTo(StateReader* r, uint64_t state) {
+    while (r->valid && r->current < state) {
+        ReaderNext(r);
+    }
+
+    return r->valid && r->current == state;
+}
+
+StateWriter* NewStateWriter(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return NULL;
+
+    StateWriter* w = malloc(sizeof(StateWriter));
+    w->file = file;
+    w->count = 0;
+    w->len = 0;
+    return w;
+}
+
+bool WriterFlush(StateWriter* w) {
+    bool success = fwrite(w->buffer, sizeof(uint64_t), w->len, w->file) == w->len;
+    w->len = 0;
+    return success;
+}
+
+bool WriterPush(StateWriter* w, uint64_t state) {
+    w->buffer[w->len++] = state;
+    w->count++;
+    return w->len < EBFS_IO_STATES || WriterFlush(w);
+}
+
+/* Flushes and closes the writer, returning false if any write failed */
+bool FreeStateWriter(StateWriter** w) {
+    bool success = WriterFlush(*w);
+    success = fclose((*w)->file) == 0 && success;
+    free(*w);
+    *w = NULL;
+    return success;
+}
+
+int CompareStates(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* Sorts the child buffer, drops duplicates and writes it out as a run file */
+bool WriteRun(uint64_t* buffer, size_t len, const char* path) {
+    StateWriter* w = NewStateWriter(path);
+    if (!w)
+        return false;
+
+    qsort(buffer, len, sizeof(uint64_t), CompareStates);
+
+    bool success = true;
+    for (size_t i = 0; i < len && success; i++) {
+        if (i == 0 || buffer[i] != buffer[i - 1])
+            success = WriterPush(w, buffer[i]);
+    }
+
+    return FreeStateWriter(&w) && success;
+}
+
+/* Restores the min-heap property of the run readers below index i */
+void SiftDownReaders(StateReader** heap, size_t count, size_t i) {
+    while (2 * i + 1 < count) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < count && heap[child + 1]->current < heap[child]->current)
+            child++;
+        if (heap[i]->current <= heap[child]->current)
+            break;
+
+        StateReader* tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+/** Merges the sorted runs into the next layer, dropping duplicates and states found in the current or previous layer.
+* current and previous may be NULL to only drop duplicates.
+* Returns false if a file could not be read or written, otherwise sets found if the goal is part of the new layer.
+*/
+bool MergeRuns(char (*runs)[EBFS_PATH_MAX], unsigned int n_runs, const char* current, const char* previous,
+    const char* next, uint64_t goal, uint64_t* count, bool* found) {
+    StateWriter* w = NewStateWriter(next);
+    if (!w)
+        return false;
+
+    StateReader* r_current = NewStateReader(current);
+    StateReader* r_previous = NewStateReader(previous);
+    bool success = r_current && r_previous;
+
+    // Min-heap of the runs that still have states, ordered by their current state
+    StateReader** heap = malloc((n_runs ? n_runs : 1) * sizeof(StateReader*));
+    size_t n_heap = 0;
+    for (unsigned int i = 0; i < n_runs && success; i++) {
+        StateReader* r = NewStateReader(runs[i]);
+        if (!r)
+            success = false;
+        else if (r->valid)
+            heap[n_heap++] = r;
+        else
+            FreeStateReader(&r);
+    }
+    for (size_t i = n_heap; i-- > 0;) {
+        SiftDownReaders(heap, n_heap, i);
+    }
+
+    bool has_last = false;
+    uint64_t last = 0;
+    *found = false;
+
+    while (n_heap > 0 && success) {
+        uint64_t state = heap[0]->current;
+
+        // Advance the run that produced the state
+        ReaderNext(heap[0]);
+        if (!heap[0]->valid) {
+            FreeStateReader(&heap[0]);
+            heap[0] = heap[--n_heap];
+        }
+        SiftDownReaders(heap, n_heap, 0);
+
+        // Keep the state if it is new
+        if (has_last && state == last)
+            continue;
+        has_last = true;
+        last = state;
+
+        if (ReaderSkipTo(r_current, state) || ReaderSkipTo(r_previous, state))
+            continue;
+
+        if (state == goal)
+            *found = true;
+        success = WriterPush(w, state);
+    }
+
+    for (size_t i = 0; i < n_heap; i++) {
+        FreeStateReader(&heap[i]);
+    }
+    free(heap);
+    if (r_current)
+        FreeStateReader(&r_current);
+    if (r_previous)
+        FreeStateReader(&r_previous);
+
+    *count = w->count;
+    return FreeStateWriter(&w) && success;
+}
+
+/** Merges groups of EBFS_MERGE_FAN_IN runs into longer runs, until at most EBFS_MERGE_FAN_IN runs are left.
+* The merged runs replace the first entries of runs. Returns false if a file could not be read or written,
+* in which case every run but the ones still listed in runs is removed.
+*/
+bool ReduceRuns(char (*runs)[EBFS_PATH_MAX], unsigned int* n_runs, const char* dir, unsigned int* run_id) {
+    while (*n_runs > EBFS_MERGE_FAN_IN) {
+        unsigned int n_merged = 0;
+
+        for (unsigned int i = 0; i < *n_runs; i += EBFS_MERGE_FAN_IN) {
+            unsigned int n_group = *n_runs - i < EBFS_MERGE_FAN_IN ? *n_runs - i : EBFS_MERGE_FAN_IN;
+            char merged[EBFS_PATH_MAX];
+            snprintf(merged, EBFS_PATH_MAX, "%s/ebfs_%d_run_%u.bin", dir, (int)getpid(), (*run_id)++);
+
+            uint64_t count = 0;
+            bool found = false;
+            bool success = MergeRuns(runs + i, n_group, NULL, NULL, merged, 0, &count, &found);
+
+            for (unsigned int j = 0; j < n_group; j++) {
+                remove(runs[i + j]);
+            }
+
+            if (!success) {
+                remove(merged);
+                for (unsigned int j = i + n_group; j < *n_runs; j++) {
+                    remove(runs[j]);
+                }
+                *n_runs = n_merged;
+                return false;
+            }
+
+            // The slot was already merged, as groups are merged in order
+            strcpy(runs[n_merged++], merged);
+        }
+
+        *n_runs = n_merged;
+    }
+
+    return true;
+}
+
+/** External-Memory Breadth-First Search Implementation
+* Layer and run files are written to dir, at most buffer_states children are held in memory at once.
+* If full_depth is set the search continues past the goal until every reachable state has been visited,
+* otherwise it stops at the goal layer. Returns NULL if the files could not be written.
+*/
+ExternalBFS* ExternalBFSRun(Board* b_init, Board* b_goal, const char* dir, size_t buffer_states, bool full_depth) {
+    ExternalBFS* e_tmp = malloc(sizeof(ExternalBFS));
+    e_tmp->Solved = false;
+    e_tmp->GoalDistance = 0;
+    e_tmp->Layers = 1;
+    e_tmp->LayerSizes = malloc(sizeof(uint64_t));
+    e_tmp->LayerSizes[0] = 1;
+    e_tmp->StatesVisited = 1;
+
+    if (buffer_states < 4)
+        buffer_states = 4;
+
+    // Begin computation timer
+    clock_t c_timer_begin = clock();
+
+    uint64_t init = PackBoard(b_init);
+    uint64_t goal = PackBoard(b_goal);
+    e_tmp->Solved = init == goal;
+
+    // Boards with a different inversion parity than the goal can never reach it
+    if (!full_depth && !IsBoardSolvable(b_init, b_goal)) {
+        e_tmp->ComputationTime = 0;
+        return e_tmp;
+    }
+
+    // Paths of the previous, current and next layers, rotated after every layer
+    char layers[3][EBFS_PATH_MAX];
+    char* previous = NULL;
+    char* current = layers[0];
+    char* next = layers[1];
+    snprintf(current, EBFS_PATH_MAX, "%s/ebfs_%d_layer_0.bin", dir, (int)getpid());
+
+    StateWriter* w = NewStateWriter(current);
+    bool success = w && WriterPush(w, init) && FreeStateWriter(&w);
+
+    uint64_t* buffer = malloc(buffer_states * sizeof(uint64_t));
+    unsigned int runs_capacity = 16;
+    char (*runs)[EBFS_PATH_MAX] = malloc(runs_capacity * sizeof(*runs));
+
+    while (success && (full_depth || !e_tmp->Solved)) {
+        unsigned int depth = e_tmp->Layers;
+        unsigned int n_runs = 0;
+        unsigned int run_id = 0;
+        size_t len = 0;
+
+        // Expand every state of the current layer, spilling sorted runs of children to disk
+        StateReader* r = NewStateReader(current);
+        if (!r) {
+            success = false;
+            break;
+        }
+        while (r->valid && success) {
+            uint64_t state = r->current;
+            int blank = PackedBlankIndex(state);
+
+            for (Move move = ABOVE; move <= RIGHT && success; move++) {
+                uint64_t child = PackedApplyMove(state, blank, move);
+                if (child == 0)
+                    continue;
+
+                buffer[len++] = child;
+                if (len == buffer_states) {
+                    if (n_runs == runs_capacity) {
+                        runs_capacity *= 2;
+                        runs = realloc(runs, runs_capacity * sizeof(*runs));
+                    }
+                    snprintf(runs[n_runs], EBFS_PATH_MAX, "%s/ebfs_%d_run_%u.bin", dir, (int)getpid(), run_id++);
+                    success = WriteRun(buffer, len, runs[n_runs++]);
+                    len = 0;
+                }
+            }
+
+            ReaderNext(r);
+        }
+        FreeStateReader(&r);
+
+        if (success && len > 0) {
+            if (n_runs == runs_capacity) {
+                runs_capacity *= 2;
+                runs = realloc(runs, runs_capacity * sizeof(*runs));
+            }
+            snprintf(runs[n_runs], EBFS_PATH_MAX, "%s/ebfs_%d_run_%u.bin", dir, (int)getpid(), run_id++);
+            success = WriteRun(buffer, len, runs[n_runs++]);
+        }
+
+        success = success && ReduceRuns(runs, &n_runs, dir, &run_id);
+
+        // Merge the runs into the next layer
+        uint64_t count = 0;
+        bool found = false;
+        snprintf(next, EBFS_PATH_MAX, "%s/ebfs_%d_layer_%u.bin", dir, (int)getpid(), depth);
+        success = success && MergeRuns(runs, n_runs, current, previous, next, goal, &count, &found);
+
+        for (unsigned int i = 0; i < n_runs; i++) {
+            remove(runs[i]);
+        }
+
+        // The layer before the current one is no longer needed
+        if (previous)
+            remove(previous);
+
+        if (!success || count == 0) {
+            remove(next);
+            break;
+        }
+
+        e_tmp->LayerSizes = realloc(e_tmp->LayerSizes, (depth + 1) * sizeof(uint64_t));
+        e_tmp->LayerSizes[depth] = count;
+        e_tmp->StatesVisited += count;
+        e_tmp->Layers++;
+
+        if (found && !e_tmp->Solved) {
+            e_tmp->Solved = true;
+            e_tmp->GoalDistance = depth;
+        }
+
+        // Rotate the layer paths
+        char* tmp = previous ? previous : layers[2];
+        previous = current;
+        current = next;
+        next = tmp;
+    }
+
+    // Remove the remaining layer files
+    if (previous)
+        remove(previous);
+    remove(current);
+
+    free(runs);
+    free(buffer);
+
+    // End computation timer
+    clock_t c_timer_end = clock();
+
+    // Get the ComputationTime in seconds
+    e_tmp->ComputationTime = (double)(c_timer_end - c_timer_begin) / CLOCKS_PER_SEC;
+
+    if (!success) {
+        free(e_tmp->LayerSizes);
+        free(e_tmp);
+        return NULL;
+    }
+
+    return e_tmp;
+}
+
+/* Prints a visual representation of the results of an external-memory BFS */
+void PrintExternalBFS(ExternalBFS* ebfs) {
+    // Create Whitespace
+    printf("\n");
+    // Print Data
+    printf("Computation Time: %f Seconds\n", ebfs->ComputationTime);
+    printf("States Visited: %llu\n", (unsigned long long)ebfs->StatesVisited);
+    if (ebfs->Solved)
+        printf("Goal Distance: %u\n", ebfs->GoalDistance);
+    else
+        printf("Goal Distance: unreachable\n");
+    printf("== Layers: %u ===================================\n", ebfs->Layers);
+
+    for (unsigned int i = 0; i < ebfs->Layers; i++) {
+        printf("Depth %u: %llu states\n", i, (unsigned long long)ebfs->LayerSizes[i]);
+    }
+    printf("=================================================\n");
+}
+
+void FreeExternalBFS(ExternalBFS** ebfs) {
+    free((*ebfs)->LayerSizes);
+    free(*ebfs);
+    *ebfs = NULL;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "Board.h"
+#include "Algorithm.h"
+
+/** Data structures shared by the best-first searches over packed boards:
+* a hash table holding the best known path to every generated board, and a binary min-heap used as open list.
+*/
+
+/* The best known path to a board */
+typedef struct StateEntry {
+    uint64_t state;     // 0 marks an empty slot
+    uint64_t parent;    // 0 for the initial board
+    unsigned int g;
+    Move move;
+    bool closed;        // Expanded with its current g
+    bool focal;         // Part of the focal list (focal search only)
+} StateEntry;
+
+/* Open-addressing hash table of boards */
+typedef struct StateTable {
+    size_t count;
+    size_t capacity;    // Always a power of two
+    StateEntry* entries;
+} StateTable;
+
+/* An entry of the open list, ordered by key and then by the deepest g */
+typedef struct OpenItem {
+    unsigned int key;
+    unsigned int g;
+    uint64_t state;
+} OpenItem;
+
+/* Binary min-heap used as open list */
+typedef struct OpenHeap {
+    size_t count;
+    size_t capacity;
+    OpenItem* items;
+} OpenHeap;
+
+/* Mixes the bits of a packed board (splitmix64 finalizer) */
+uint64_t HashState(uint64_t state) {
+    state = (state ^ (state >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    state = (state ^ (state >> 27)) * 0x94d049bb133111ebULL;
+    return state ^ (state >> 31);
+}
+
+/* Returns the slot of a board, or the empty slot where it belongs */
+StateEntry* StateTableFind(StateTable* t, uint64_t state) {
+    size_t index = (size_t)(HashState(state) >> 32) & (t->capacity - 1);
+
+    while (t->entries[index].state != 0 && t->entries[index].state != state) {
+        index = (index + 1) & (t->capacity - 1);
+    }
+
+    return &t->entries[index];
+}
+
+/* Returns the slot of a board, claiming an empty one (and growing the table) if it is not stored yet */
+StateEntry* StateTableInsert(StateTable* t, uint64_t state, bool* inserted) {
+    // Keep the table at most half full
+    if ((t->count + 1) * 2 > t->capacity) {
+        StateEntry* old = t->entries;
+        size_t old_capacity = t->capacity;
+
+        t->capacity = old_capacity ? old_capacity * 2 : 1024;
+        t->entries = TrackedCalloc(MEMORY_STATE_TABLE, t->capacity, sizeof(StateEntry));
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i].state != 0)
+                *StateTableFind(t, old[i].state) = old[i];
+        }
+        TrackedFree(MEMORY_STATE_TABLE, old, old_capacity * sizeof(StateEntry));
+    }
+
+    StateEntry* e = StateTableFind(t, state);
+    *inserted = e->state == 0;
+    if (*inserted) {
+        e->state = state;
+        e->closed = false;
+        e->focal = false;
+        t->count++;
+    }
+
+    return e;
+}
+
+void FreeStateTable(StateTable* t) {
+    TrackedFree(MEMORY_STATE_TABLE, t->entries, t->capacity * sizeof(StateEntry));
+    t->entries = NULL;
+    t->count = 0;
+    t->capacity = 0;
+}
+
+bool OpenItemLess(OpenItem const* a, OpenItem const* b) {
+    return a->key < b->key || (a->key == b->key && a->g > b->g);
+}
+
+void OpenHeapPush(OpenHeap* h, OpenItem item) {
+    if (h->count == h->capacity) {
+        size_t old_size = h->capacity * sizeof(OpenItem);
+        h->capacity = h->capacity ? h->capacity * 2 : 1024;
+        h->items = TrackedRealloc(MEMORY_OPEN_LIST, h->items, old_size, h->capacity * sizeof(OpenItem));
+    }
+
+    // Sift up
+    size_t i = h->count++;
+    while (i > 0 && OpenItemLess(&item, &h->items[(i - 1) / 2])) {
+        h->items[i] = h->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h->items[i] = item;
+}
+
+OpenItem OpenHeapPop(OpenHeap* h) {
+    OpenItem top = h->items[0];
+    OpenItem last = h->items[--h->count];
+
+    // Sift down
+    size_t i = 0;
+    while (2 * i + 1 < h->count) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < h->count && OpenItemLess(&h->items[child + 1], &h->items[child]))
+            child++;
+        if (!OpenItemLess(&h->items[child], &last))
+            break;
+        h->items[i] = h->items[child];
+        i = child;
+    }
+    if (h->count > 0)
+        h->items[i] = last;
+
+    return top;
+}
+
+void FreeOpenHeap(OpenHeap* h) {
+    TrackedFree(MEMORY_OPEN_LIST, h->items, h->capacity * sizeof(OpenItem));
+    h->items = NULL;
+    h->count = 0;
+    h->capacity = 0;
+}
+
+/* Builds the path to a board by following the parents stored in the table back to the initial board */
+Path* StateTablePath(StateTable* t, uint64_t state) {
+    Path* p_head = NULL;
+    Path* p_tmp = NULL;
+
+    while (state != 0) {
+        StateEntry* e = StateTableFind(t, state);
+
+        p_tmp = TrackedAlloc(MEMORY_PATH, sizeof(Path));
+        p_tmp->move = e->move;
+        p_tmp->next = p_head;
+        p_head = p_tmp;
+
+        state = e->parent;
+    }
+
+    return p_head;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "Board.h"
+#include "Frontier.h"
+#include "BatchIO.h"
+
+/** Instance generator
+* Produces solvable boards from a seedable random number generator, independent of rand(), either sampled
+* uniformly over every board that can reach the goal or uniformly over the boards exactly a given number of moves
+* away from the goal.
+* Large batches can be written straight to a batch file of boards (see BatchIO.h) for load tests.
+*/
+
+/* State of the xoshiro256** random number generator */
+typedef struct Random {
+    uint64_t s[4];
+} Random;
+
+/* Seeds the generator, the same seed always produces the same sequence */
+void SeedRandom(Random* r, uint64_t seed) {
+    // Expand the seed with splitmix64 so that no state word is zero
+    for (int i = 0; i < 4; i++) {
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        r->s[i] = z ^ (z >> 31);
+    }
+}
+
+uint64_t RotateLeft(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/* Returns the next 64 random bits */
+uint64_t NextRandom(Random* r) {
+    uint64_t result = RotateLeft(r->s[1] * 5, 7) * 9;
+    uint64_t t = r->s[1] << 17;
+
+    r->s[2] ^= r->s[0];
+    r->s[3] ^= r->s[1];
+    r->s[1] ^= r->s[2];
+    r->s[0] ^= r->s[3];
+    r->s[2] ^= t;
+    r->s[3] = RotateLeft(r->s[3], 45);
+
+    return result;
+}
+
+/* Returns a uniformly distributed number in [0, n) (Lemire's multiply and reject method) */
+uint32_t RandomBelow(Random* r, uint32_t n) {
+    uint64_t m = (NextRandom(r) >> 32) * n;
+
+    if ((uint32_t)m < n) {
+        uint32_t threshold = (uint32_t)(-n) % n;
+        while ((uint32_t)m < threshold) {
+            m = (NextRandom(r) >> 32) * n;
+        }
+    }
+
+    return (uint32_t)(m >> 32);
+}
+
+/* Creates a board drawn uniformly from every board that can reach the goal */
+void NewRandomSolvableBoard(Random* r, Board const* b_goal, Board* b) {
+    int* cells = &b->config[0][0];
+    for (int i = 0; i < 9; i++) {
+        cells[i] = i;
+    }
+
+    // Fisher-Yates shuffle
+    for (int i = 0; i < 9 - 1; i++) {
+        int j = i + (int)RandomBelow(r, (uint32_t)(9 - i));
+        int t = cells[j];
+        cells[j] = cells[i];
+        cells[i] = t;
+    }
+
+    MakeSolvable(cells, &b_goal->config[0][0]);
+    b->move = NONE;
+}
+
+/* The packed boards whose shortest path to the goal is exactly depth moves */
+typedef struct DepthShell {
+    uint64_t* boards;
+    size_t count;
+} DepthShell;
+
+/** Finds the boards exactly depth moves away from the goal with a breadth-first search from the goal.
+* A random walk of depth moves can end much closer to the goal than depth, so instances of a known difficulty are
+* drawn from this layer instead. Returns false if no board is that far from the goal (no goal is more than 31 moves
+* away from any board).
+*/
+bool NewDepthShell(DepthShell* shell, Board const* b_goal, unsigned int depth) {
+    StateTable table = { 0 };
+    bool inserted;
+    uint64_t* layer = malloc(sizeof(uint64_t));
+    size_t n_layer = 1;
+
+    layer[0] = PackBoard(b_goal);
+    StateTableInsert(&table, layer[0], &inserted);
+
+    for (unsigned int d = 0; d < depth && n_layer > 0; d++) {
+        uint64_t* next = malloc(4 * n_layer * sizeof(uint64_t));
+        size_t n_next = 0;
+
+        // The boards first reached from this layer are one move further away
+        for (size_t i = 0; i < n_layer; i++) {
+            int blank = PackedBlankIndex(layer[i]);
+            for (Move move = ABOVE; move <= RIGHT; move++) {
+                uint64_t child = PackedApplyMove(layer[i], blank, move);
+                if (child == 0)
+                    continue;
+
+                StateTableInsert(&table, child, &inserted);
+                if (inserted)
+                    next[n_next++] = child;
+            }
+        }
+
+        free(layer);
+        layer = next;
+        n_layer = n_next;
+    }
+
+    FreeStateTable(&table);
+    shell->boards = layer;
+    shell->count = n_layer;
+
+    return n_layer > 0;
+}
+
+void FreeDepthShell(DepthShell* shell) {
+    free(shell->boards);
+    shell->boards = NULL;
+    shell->count = 0;
+}
+
+/* Creates a board drawn uniformly from the boards of a shell, see NewDepthShell */
+void NewRandomDepthBoard(Random* r, DepthShell const* shell, Board* b) {
+    UnpackBoard(shell->boards[RandomBelow(r, (uint32_t)shell->count)], b);
+}
+
+/** Writes count generated boards, each paired with the goal, to a batch file of boards.
+* Boards are sampled uniformly if shell is NULL, otherwise uniformly from the boards of the shell.
+* With append, the boards are added to the records already in the file.
+* Returns false if the file could not be written.
+*/
+bool WriteInstanceBatch(const char* path, Random* r, Board const* b_goal, size_t count, DepthShell const* shell,
+    bool append) {
+    BatchWriter* w = NewBatchWriter(path, BATCH_BOARDS, append);
+    if (!w)
+        return false;
+
+    Board b;
+    bool success = true;
+    for (size_t i = 0; i < count && success; i++) {
+        if (!shell)
+            NewRandomSolvableBoard(r, b_goal, &b);
+        else
+            NewRandomDepthBoard(r, shell, &b);
+
+        success = AppendBoardRecord(w, &b, b_goal);
+    }
+
+    return CloseBatchWriter(&w) && success;
+}
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "Board.h"
+#include "Algorithm.h"
+#include "Frontier.h"
+
+#define HDA_MAX_THREADS 256     // Max number of worker threads
+#define HDA_BATCH_SIZE 64       // Number of states sent to another thread at once
+#define HDA_FLUSH_INTERVAL 32   // Number of expansions after which partial batches are sent anyway
+
+/** Hash-Distributed A* (HDA*)
+* Every state is owned by exactly one worker thread, chosen by a hash of its packed board.
+* A worker keeps the open list and the table of best known path costs for the states it owns, so duplicates are
+* detected without any locking. Children owned by another worker are sent to it in batches through a lock-free
+* multiple-producer single-consumer queue (its inbox).
+*
+* The search terminates once no worker has a node left whose f = g + h is below the best solution found
+* and no batches are in flight, so the solution is optimal for the (admissible) Manhattan Distance.
+*/
+
+/* A state sent to the worker that owns it */
+typedef struct HDAMessage {
+    uint64_t state;
+    uint64_t parent;
+    unsigned int g;
+    Move move;
+} HDAMessage;
+
+/* A batch of states, linked into the inbox of the worker that owns them */
+typedef struct HDABatch {
+    _Atomic(struct HDABatch*) next;
+    unsigned int count;
+    HDAMessage messages[HDA_BATCH_SIZE];
+} HDABatch;
+
+/* Multiple-producer single-consumer queue of batches (intrusive, with a stub node) */
+typedef struct HDAInbox {
+    _Atomic(HDABatch*) head;    // Where producers push
+    HDABatch* tail;             // Where the owner pops
+    HDABatch stub;
+} HDAInbox;
+
+typedef struct HDASearch HDASearch;
+
+typedef struct HDAWorker {
+    pthread_t thread;
+    unsigned int id;
+    HDASearch* search;
+
+    HDAInbox inbox;
+    OpenHeap open;
+    StateTable closed;
+    HDABatch* outgoing[HDA_MAX_THREADS];
+
+    unsigned int expanded;
+    unsigned int since_flush;
+} HDAWorker;
+
+struct HDASearch {
+    unsigned int n_workers;
+    HDAWorker* workers;
+
+    uint64_t goal;
+    int goal_pos[9];
+    MemoryAccount* memory;  // Account of the search, joined by every worker (see Memory.h)
+
+    // Cost of the best solution found so far, UINT_MAX if none
+    _Alignas(64) atomic_uint best;
+    // Number of busy workers plus the number of batches in flight, the search is over once it reaches 0
+    _Alignas(64) atomic_long active;
+};
+
+/* Returns the id of the worker owning a state */
+unsigned int HDAOwner(HDASearch* s, uint64_t state) {
+    return (unsigned int)((HashState(state) & 0xFFFFFFFF) % s->n_workers);
+}
+
+void HDAInboxInit(HDAInbox* inbox) {
+    atomic_store_explicit(&inbox->stub.next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&inbox->head, &inbox->stub, memory_order_relaxed);
+    inbox->tail = &inbox->stub;
+}
+
+/* Pushes a batch into an inbox, may be called from any thread */
+void HDAInboxPush(HDAInbox* inbox, HDABatch* batch) {
+    atomic_store_explicit(&batch->next, NULL, memory_order_relaxed);
+    HDABatch* prev = atomic_exchange_explicit(&inbox->head, batch, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, batch, memory_order_release);
+}
+
+/** Pops a batch from an inbox, may only be called by its owner.
+* Returns NULL if the inbox is empty or a push is still in progress.
+*/
+HDABatch* HDAInboxPop(HDAInbox* inbox) {
+    HDABatch* tail = inbox->tail;
+    HDABatch* next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    // Skip over the stub
+    if (tail == &inbox->stub) {
+        if (!next)
+            return NULL;
+        inbox->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+
+    if (next) {
+        inbox->tail = next;
+        return tail;
+    }
+
+    // The tail is the last batch, put the stub behind it so it can be popped
+    if (tail != atomic_load_explicit(&inbox->head, memory_order_acquire))
+        return NULL;
+
+    HDAInboxPush(inbox, &inbox->stub);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next) {
+        inbox->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+/* Records a path to a state owned by this worker, opening it if the path is the best one found so far */
+void HDARelax(HDAWorker* w, HDAMessage const* m) {
+    HDASearch* s = w->search;
+    unsigned int f = m->g + PackedManhattanDistance(m->state, s->goal_pos);
+
+    // Nothing beyond the best solution found so far can improve on it
+    if (f >= atomic_load_explicit(&s->best, memory_order_relaxed))
+        return;
+
+    bool inserted;
+    StateEntry* e = StateTableInsert(&w->closed, m->state, &inserted);
+    if (!inserted && e->g <= m->g)
+        return;
+
+    e->parent = m->parent;
+    e->g = m->g;
+    e->move = m->move;
+
+    OpenItem item = { f, m->g, m->state };
+    OpenHeapPush(&w->open, item);
+}
+
+/* Sends a batch to its owner, it stays counted as active until the owner has processed it */
+void HDASendBatch(HDAWorker* w, unsigned int owner) {
+    atomic_fetch_add_explicit(&w->search->active, 1, memory_order_acq_rel);
+    HDAInboxPush(&w->search->workers[owner].inbox, w->outgoing[owner]);
+    w->outgoing[owner] = NULL;
+}
+
+/* Sends every partially filled batch */
+void HDAFlush(HDAWorker* w) {
+    for (unsigned int i = 0; i < w->search->n_workers; i++) {
+        if (w->outgoing[i])
+            HDASendBatch(w, i);
+    }
+    w->since_flush = 0;
+}
+
+/* Hands a state to its owner, directly if it is owned by this worker */
+void HDASend(HDAWorker* w, HDAMessage const* m) {
+    unsigned int owner = HDAOwner(w->search, m->state);
+
+    if (owner == w->id) {
+        HDARelax(w, m);
+        return;
+    }
+
+    if (!w->outgoing[owner]) {
+        w->outgoing[owner] = malloc(sizeof(HDABatch));
+        w->outgoing[owner]->count = 0;
+    }
+
+    HDABatch* b = w->outgoing[owner];
+    b->messages[b->count++] = *m;
+    if (b->count == HDA_BATCH_SIZE)
+        HDASendBatch(w, owner);
+}
+
+/** Expands the best open node of this worker.
+* Returns false if there is no open node that could still improve on the best solution.
+*/
+bool HDAExpandNext(HDAWorker* w) {
+    HDASearch* s = w->search;
+
+    while (w->open.count > 0) {
+        unsigned int best = atomic_load_explicit(&s->best, memory_order_relaxed);
+        if (w->open.items[0].key >= best) {
+            // The remaining nodes can never lead to a better solution
+            w->open.count = 0;
+            return false;
+        }
+
+        OpenItem item = OpenHeapPop(&w->open);
+        StateEntry* e = StateTableFind(&w->closed, item.state);
+
+        // Skip nodes that were reopened with a cheaper path since they were pushed
+        if (e->g != item.g)
+            continue;
+
+        if (item.state == s->goal) {
+            // Lower the best solution cost if this one is cheaper
+            while (item.g < best && !atomic_compare_exchange_weak_explicit(&s->best, &best, item.g,
+                memory_order_acq_rel, memory_order_relaxed)) {
+            }
+            return true;
+        }
+
+        w->expanded++;
+
+        // Relaxing local children may grow the table, so the entry must not be used past this point
+        uint64_t parent = e->parent;
+        int blank = PackedBlankIndex(item.state);
+        for (Move move = ABOVE; move <= RIGHT; move++) {
+            uint64_t child = PackedApplyMove(item.state, blank, move);
+            if (child == 0 || child == parent)
+                continue;
+
+            HDAMessage m = { child, item.state, item.g + 1, move };
+            HDASend(w, &m);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void* HDAWorkerRun(void* arg) {
+    HDAWorker* w = arg;
+    HDASearch* s = w->search;
+    bool busy = true;
+
+    MemoryJoinSearch(s->memory);
+
+    for (;;) {
+        // Take in the states sent by other workers
+        HDABatch* b;
+        while ((b = HDAInboxPop(&w->inbox))) {
+            if (!busy) {
+                atomic_fetch_add_explicit(&s->active, 1, memory_order_acq_rel);
+                busy = true;
+            }
+
+            for (unsigned int i = 0; i < b->count; i++) {
+                HDARelax(w, &b->messages[i]);
+            }
+            free(b);
+            atomic_fetch_sub_explicit(&s->active, 1, memory_order_acq_rel);
+        }
+
+        if (HDAExpandNext(w)) {
+            if (++w->since_flush >= HDA_FLUSH_INTERVAL)
+                HDAFlush(w);
+            continue;
+        }
+
+        // Out of work, hand over everything generated so far and wait for more
+        HDAFlush(w);
+        if (busy) {
+            busy = false;
+            atomic_fetch_sub_explicit(&s->active, 1, memory_order_acq_rel);
+        }
+
+        if (atomic_load_explicit(&s->active, memory_order_acquire) == 0)
+            break;
+
+        sched_yield();
+    }
+
+    return NULL;
+}
+
+/** Hash-Distributed A* Implementation using n_threads worker threads.
+* Returns the same result as the other searches, with an optimal path if the goal is reachable.
+*/
+Algorithm* HDAStar(Board* b_init, Board* b_goal, unsigned int n_threads) {
+    Algorithm* a_tmp = NewAlgorithm();
+
+    if (n_threads < 1)
+        n_threads = 1;
+    if (n_threads > HDA_MAX_THREADS)
+        n_threads = HDA_MAX_THREADS;
+
+    if (RejectUnsolvable(b_init, b_goal))
+        return a_tmp;
+
+    // Wall-clock time, clock() would add up the time of every thread
+    struct timespec t_begin, t_end;
+    clock_gettime(CLOCK_MONOTONIC, &t_begin);
+    MemoryAccount m_search;
+    MemoryBeginSearch(&m_search);
+
+    HDASearch search;
+    search.n_workers = n_threads;
+    search.workers = calloc(n_threads, sizeof(HDAWorker));
+    search.goal = PackBoard(b_goal);
+    GetGoalPositions(b_goal, search.goal_pos);
+    search.memory = &m_search;
+    atomic_init(&search.best, UINT_MAX);
+    atomic_init(&search.active, (long)n_threads);
+
+    for (unsigned int i = 0; i < n_threads; i++) {
+        search.workers[i].id = i;
+        search.workers[i].search = &search;
+        HDAInboxInit(&search.workers[i].inbox);
+    }
+
+    // Hand the initial board to its owner before any thread starts
+    uint64_t init = PackBoard(b_init);
+    HDAMessage m_root = { init, 0, 0, NONE };
+    HDARelax(&search.workers[HDAOwner(&search, init)], &m_root);
+
+    for (unsigned int i = 0; i < n_threads; i++) {
+        pthread_create(&search.workers[i].thread, NULL, HDAWorkerRun, &search.workers[i]);
+    }
+    for (unsigned int i = 0; i < n_threads; i++) {
+        pthread_join(search.workers[i].thread, NULL);
+        a_tmp->NodesVisited += search.workers[i].expanded;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    a_tmp->ComputationTime = (double)(t_end.tv_sec - t_begin.tv_sec) + (double)(t_end.tv_nsec - t_begin.tv_nsec) / 1e9;
+
+    // Follow the parents from the goal back to the initial board, every step strictly lowers g
+    unsigned int best = atomic_load(&search.best);
+    if (best != UINT_MAX) {
+        a_tmp->Solved = true;
+        a_tmp->MovesPerformed = best;
+        a_tmp->Bound = 1.0;
+
+        Path* p_tmp = NULL;
+        uint64_t state = search.goal;
+        while (state != 0) {
+            StateEntry* e = StateTableFind(&search.workers[HDAOwner(&search, state)].closed, state);
+
+            p_tmp = TrackedAlloc(MEMORY_PATH, sizeof(Path));
+            p_tmp->move = e->move;
+            p_tmp->next = a_tmp->path;
+            a_tmp->path = p_tmp;
+
+            state = e->parent;
+        }
+    }
+
+    // Deallocate the workers from memory
+    for (unsigned int i = 0; i < n_threads; i++) {
+        FreeOpenHeap(&search.workers[i].open);
+        FreeStateTable(&search.workers[i].closed);
+    }
+    free(search.workers);
+    MemoryEndSearch(&m_search, &a_tmp->Memory);
+
+    return a_tmp;
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+
+#include "Board.h"
+#include "Algorithm.h"
+#include "Transposition.h"
+
+/** Iterative-Deepening A* (IDA*)
+* Repeats a depth-first search bounded by f = g + h, raising the bound to the smallest f that exceeded it,
+* until the goal is found. Memory only grows with the depth of the solution.
+*
+* With a transposition table, a board already searched at a smaller or equal depth during the same iteration
+* is not searched again, and the lower bound learned from every searched subtree (the smallest bound of its
+* children plus one) replaces the Manhattan Distance when it is larger. Children are searched in order of their
+* lower bound, so the goal is usually reached early in the last iteration.
+*/
+
+/* A child board with the lower bound used to order it */
+typedef struct IDAChild {
+    uint64_t state;
+    Move move;
+    unsigned int bound;
+} IDAChild;
+
+/* The state of an IDA* search */
+typedef struct IDAContext {
+    uint64_t goal;
+    int goal_pos[9];
+    TranspositionTable* tt;
+
+    unsigned int threshold;         // Current bound on f
+    unsigned int next_threshold;    // Smallest f found above the current bound
+    bool found;
+    unsigned int solution_depth;
+    unsigned int expanded;
+    unsigned int max_nodes;
+    bool aborted;                   // Set once max_nodes boards were expanded or the search was stopped
+
+    Move* moves;                    // Moves from the initial board to the goal, filled in once it is found
+} IDAContext;
+
+/* Returns the best known lower bound on the number of moves from a board to the goal */
+unsigned int IDALowerBound(IDAContext* c, uint64_t state) {
+    unsigned int h = PackedManhattanDistance(state, c->goal_pos);
+
+    TTProbe probe;
+    if (c->tt && TTProbeState(c->tt, state, &probe) && probe.bound > h)
+        return probe.bound;
+
+    return h;
+}
+
+/** Generates the children of a board, sorted so that the ones closest to the goal come first.
+* Returns the number of children.
+*/
+unsigned int OrderChildren(IDAContext* c, uint64_t state, IDAChild children[4]) {
+    int blank = PackedBlankIndex(state);
+    unsigned int count = 0;
+
+    for (Move move = ABOVE; move <= RIGHT; move++) {
+        uint64_t child = PackedApplyMove(state, blank, move);
+        if (child == 0)
+            continue;
+
+        IDAChild item = { child, move, IDALowerBound(c, child) };
+
+        // Insertion sort by lower bound
+        unsigned int i = count++;
+        while (i > 0 && children[i - 1].bound > item.bound) {
+            children[i] = children[i - 1];
+            i--;
+        }
+        children[i] = item;
+    }
+
+    return count;
+}
+
+/** Searches below a board reached after g moves, whose lower bound is bound.
+* Returns the lower bound learned for the board.
+*/
+unsigned int IDASearch(IDAContext* c, uint64_t state, uint64_t parent, unsigned int g, unsigned int bound) {
+    unsigned int f = g + bound;
+    if (f > c->threshold) {
+        if (f < c->next_threshold)
+            c->next_threshold = f;
+        return bound;
+    }
+
+    if (state == c->goal) {
+        c->found = true;
+        c->solution_depth = g;
+        return 0;
+    }
+
+    if (c->tt) {
+        // This iteration already searched the board with at least as many moves left
+        TTProbe probe;
+        if (TTProbeState(c->tt, state, &probe) && probe.generation == c->tt->generation && probe.g <= g)
+            return bound;
+
+        TTStore(c->tt, state, g, bound);
+    }
+
+    if (c->expanded >= c->max_nodes || IsSearchStopped()) {
+        c->aborted = true;
+        return bound;
+    }
+    c->expanded++;
+
+    IDAChild children[4];
+    unsigned int count = OrderChildren(c, state, children);
+    unsigned int learned = UINT_MAX;
+
+    for (unsigned int i = 0; i < count; i++) {
+        // Going back to the parent is never part of a shortest path, but still bounds the distance of this board
+        if (children[i].state == parent) {
+            if (children[i].bound + 1 < learned)
+                learned = children[i].bound + 1;
+            continue;
+        }
+
+        unsigned int child_bound = IDASearch(c, children[i].state, state, g + 1, children[i].bound);
+        if (c->found) {
+            c->moves[g] = children[i].move;
+            return 0;
+        }
+        if (c->aborted)
+            return bound;
+
+        if (child_bound + 1 < learned)
+            learned = child_bound + 1;
+    }
+
+    if (learned < bound)
+        learned = bound;
+
+    if (c->tt)
+        TTStore(c->tt, state, g, learned);
+
+    return learned;
+}
+
+/** Iterative-Deepening A* Implementation, giving up after expanding max_nodes boards
+* tt may be NULL to search without a transposition table. A table may be kept between searches
+* towards the same goal, in which case the bounds learned by earlier searches are reused.
+*/
+Algorithm* IDAStar_Bounded(Board* b_init, Board* b_goal, TranspositionTable* tt, unsigned int max_nodes) {
+    Algorithm* a_tmp = NewAlgorithm();
+
+    if (RejectUnsolvable(b_init, b_goal))
+        return a_tmp;
+
+    // Begin computation timer
+    clock_t c_timer_begin = clock();
+    MemoryAccount m_search;
+    MemoryBeginSearch(&m_search);
+
+    IDAContext c;
+    c.goal = PackBoard(b_goal);
+    GetGoalPositions(b_goal, c.goal_pos);
+    c.tt = tt;
+    c.found = false;
+    c.solution_depth = 0;
+    c.expanded = 0;
+    c.max_nodes = max_nodes;
+    c.aborted = false;
+    c.moves = NULL;
+
+    if (tt)
+        TTBeginSearch(tt, c.goal);
+
+    uint64_t init = PackBoard(b_init);
+    c.threshold = IDALowerBound(&c, init);
+
+    while (!c.found && !c.aborted) {
+        if (tt)
+            TTNewGeneration(tt);
+
+        // A solution found in this iteration has at most threshold moves
+        c.moves = realloc(c.moves, (c.threshold + 1) * sizeof(Move));
+        c.next_threshold = UINT_MAX;
+
+        IDASearch(&c, init, 0, 0, IDALowerBound(&c, init));
+
+        if (c.next_threshold == UINT_MAX)
+            break;
+        c.threshold = c.next_threshold;
+    }
+
+    // End computation timer
+    clock_t c_timer_end = clock();
+
+    // Get the ComputationTime in seconds
+    a_tmp->ComputationTime = (double)(c_timer_end - c_timer_begin) / CLOCKS_PER_SEC;
+    a_tmp->NodesVisited = c.expanded;
+
+    if (c.found) {
+        a_tmp->Solved = true;
+        a_tmp->MovesPerformed = c.solution_depth;
+        a_tmp->Bound = 1.0;
+
+        // Build the path backwards, starting with the goal and ending with the initial board
+        Path* p_tmp = NULL;
+        for (unsigned int i = c.solution_depth + 1; i-- > 0;) {
+            p_tmp = TrackedAlloc(MEMORY_PATH, sizeof(Path));
+            p_tmp->move = i > 0 ? c.moves[i - 1] : NONE;
+            p_tmp->next = a_tmp->path;
+            a_tmp->path = p_tmp;
+        }
+    }
+
+    free(c.moves);
+    MemoryEndSearch(&m_search, &a_tmp->Memory);
+
+    return a_tmp;
+}
+
+/* Iterative-Deepening A* Implementation, see IDAStar_Bounded */
+Algorithm* IDAStar(Board* b_init, Board* b_goal, TranspositionTable* tt) {
+    return IDAStar_Bounded(b_init, b_goal, tt, UINT_MAX);
+}
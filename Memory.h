@@ -0,0 +1,244 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+/** Allocation tracking
+* The search data structures are allocated through TrackedAlloc and released through TrackedFree, which count
+* the allocations, frees and live bytes of each type of structure, and the most bytes that were live at once.
+* Counters are updated with relaxed atomics so that threads can allocate concurrently (see HDAStar.h), and the
+* overhead is a few uncontended atomic additions per allocation.
+*
+* Each search counts its own allocations in a MemoryAccount: MemoryBeginSearch makes it the account of the calling
+* thread (threads working for the search join it with MemoryJoinSearch), and MemoryEndSearch reports it in the
+* result. Searches running at the same time on different threads (see Daemon.h) therefore never see each other's
+* allocations. The process-wide counters are only kept for the leak report (FPrintMemoryLeaks).
+* Build with -DNO_MEMORY_TRACKING to allocate with malloc and free directly, every count is then 0.
+*/
+
+/* The structures whose memory is tracked */
+typedef enum MemoryType {
+    MEMORY_BOARD,
+    MEMORY_NODE,
+    MEMORY_QUEUE_NODE,
+    MEMORY_NODE_QUEUE,
+    MEMORY_PATH,
+    MEMORY_STATE_TABLE,     // See Frontier.h
+    MEMORY_OPEN_LIST,
+    MEMORY_TYPES,
+} MemoryType;
+
+/* Memory allocated by a search, for one type or in total */
+typedef struct MemoryUsage {
+    unsigned long Allocations;
+    unsigned long Frees;
+    size_t LiveBytes;       // Still allocated when the search ended, normally only the path of the result
+    size_t PeakBytes;       // Most bytes allocated at once during the search
+} MemoryUsage;
+
+typedef struct MemoryStats {
+    MemoryUsage Total;
+    MemoryUsage Types[MEMORY_TYPES];
+} MemoryStats;
+
+typedef struct MemoryCounters {
+    _Atomic unsigned long allocations;
+    _Atomic unsigned long frees;
+    _Atomic size_t live_bytes;
+    _Atomic size_t peak_bytes;
+} MemoryCounters;
+
+/* The counters of a single search, shared by the threads working for it */
+typedef struct MemoryAccount {
+    MemoryCounters types[MEMORY_TYPES];
+    MemoryCounters total;
+    struct MemoryAccount* outer;    // Account of the thread before the search started
+} MemoryAccount;
+
+char* MemoryTypeStr[MEMORY_TYPES] = { "Board", "Node", "QueueNode", "NodeQueue", "Path", "StateTable", "OpenList" };
+
+MemoryCounters MemoryByType[MEMORY_TYPES];
+MemoryCounters MemoryTotal;
+
+// Account of the search the thread is working for, NULL outside of searches
+_Thread_local MemoryAccount* MemoryCurrent = NULL;
+
+/* Raises a peak to live if it is higher */
+void RaisePeak(_Atomic size_t* peak, size_t live) {
+    size_t current = atomic_load_explicit(peak, memory_order_relaxed);
+    while (live > current
+        && !atomic_compare_exchange_weak_explicit(peak, &current, live, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void CountAlloc(MemoryCounters* c, size_t size) {
+    atomic_fetch_add_explicit(&c->allocations, 1, memory_order_relaxed);
+    RaisePeak(&c->peak_bytes, atomic_fetch_add_explicit(&c->live_bytes, size, memory_order_relaxed) + size);
+}
+
+void CountFree(MemoryCounters* c, size_t size) {
+    atomic_fetch_add_explicit(&c->frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&c->live_bytes, size, memory_order_relaxed);
+}
+
+/* Counts an allocation in the process-wide counters and in the account of the current search */
+void CountTrackedAlloc(MemoryType type, size_t size) {
+    CountAlloc(&MemoryByType[type], size);
+    CountAlloc(&MemoryTotal, size);
+
+    MemoryAccount* a = MemoryCurrent;
+    if (a) {
+        CountAlloc(&a->types[type], size);
+        CountAlloc(&a->total, size);
+    }
+}
+
+void CountTrackedFree(MemoryType type, size_t size) {
+    CountFree(&MemoryByType[type], size);
+    CountFree(&MemoryTotal, size);
+
+    MemoryAccount* a = MemoryCurrent;
+    if (a) {
+        CountFree(&a->types[type], size);
+        CountFree(&a->total, size);
+    }
+}
+
+#ifdef NO_MEMORY_TRACKING
+
+void* TrackedAlloc(MemoryType type, size_t size) {
+    (void)type;
+    return malloc(size);
+}
+
+void* TrackedCalloc(MemoryType type, size_t count, size_t size) {
+    (void)type;
+    return calloc(count, size);
+}
+
+void* TrackedRealloc(MemoryType type, void* ptr, size_t old_size, size_t new_size) {
+    (void)type;
+    (void)old_size;
+    return realloc(ptr, new_size);
+}
+
+void TrackedFree(MemoryType type, void* ptr, size_t size) {
+    (void)type;
+    (void)size;
+    free(ptr);
+}
+
+#else
+
+void* TrackedAlloc(MemoryType type, size_t size) {
+    void* ptr = malloc(size);
+    if (ptr)
+        CountTrackedAlloc(type, size);
+    return ptr;
+}
+
+void* TrackedCalloc(MemoryType type, size_t count, size_t size) {
+    void* ptr = calloc(count, size);
+    if (ptr)
+        CountTrackedAlloc(type, count * size);
+    return ptr;
+}
+
+/* Resizes a buffer of old_size bytes (NULL with an old_size of 0), counted as a free and an allocation */
+void* TrackedRealloc(MemoryType type, void* ptr, size_t old_size, size_t new_size) {
+    void* new_ptr = realloc(ptr, new_size);
+    if (new_ptr) {
+        if (ptr)
+            CountTrackedFree(type, old_size);
+        CountTrackedAlloc(type, new_size);
+    }
+    return new_ptr;
+}
+
+/* Releases an allocation of size bytes, as passed to TrackedAlloc */
+void TrackedFree(MemoryType type, void* ptr, size_t size) {
+    if (!ptr)
+        return;
+
+    free(ptr);
+    CountTrackedFree(type, size);
+}
+
+#endif
+
+/* Starts counting the allocations of the calling thread in a new account, before a search */
+void MemoryBeginSearch(MemoryAccount* a) {
+    memset(a, 0, sizeof(MemoryAccount));
+    a->outer = MemoryCurrent;
+    MemoryCurrent = a;
+}
+
+/* Counts the allocations of the calling thread in the account of a search started by another thread */
+void MemoryJoinSearch(MemoryAccount* a) {
+    MemoryCurrent = a;
+}
+
+/* Reads a set of counters, a search that freed memory allocated before it started has no live bytes left */
+void ReadMemoryCounters(MemoryCounters* c, MemoryUsage* u) {
+    long live = (long)atomic_load_explicit(&c->live_bytes, memory_order_relaxed);
+
+    u->Allocations = atomic_load_explicit(&c->allocations, memory_order_relaxed);
+    u->Frees = atomic_load_explicit(&c->frees, memory_order_relaxed);
+    u->LiveBytes = live > 0 ? (size_t)live : 0;
+    u->PeakBytes = atomic_load_explicit(&c->peak_bytes, memory_order_relaxed);
+}
+
+/* Fills in what was allocated since MemoryBeginSearch and stops counting in the account */
+void MemoryEndSearch(MemoryAccount* a, MemoryStats* stats) {
+    for (int i = 0; i < MEMORY_TYPES; i++) {
+        ReadMemoryCounters(&a->types[i], &stats->Types[i]);
+    }
+    ReadMemoryCounters(&a->total, &stats->Total);
+
+    MemoryCurrent = a->outer;
+}
+
+/* Writes the memory used by a search to a file, one line per type that was allocated */
+void FPrintMemoryStats(FILE* out, MemoryStats const* stats) {
+    fprintf(out, "Peak Memory: %zu Bytes (%lu Allocations)\n", stats->Total.PeakBytes, stats->Total.Allocations);
+
+    for (int i = 0; i < MEMORY_TYPES; i++) {
+        MemoryUsage const* u = &stats->Types[i];
+        if (u->Allocations == 0)
+            continue;
+
+        fprintf(out, "  %-10s peak %zu Bytes, %lu allocations, %lu frees, %zu Bytes live\n",
+            MemoryTypeStr[i], u->PeakBytes, u->Allocations, u->Frees, u->LiveBytes);
+    }
+}
+
+/** Writes every allocation that was never freed to a file, returns false if there were any.
+* Only meaningful once every search result has been freed.
+*/
+bool FPrintMemoryLeaks(FILE* out) {
+    bool clean = true;
+
+    for (int i = 0; i < MEMORY_TYPES; i++) {
+        unsigned long allocations = atomic_load_explicit(&MemoryByType[i].allocations, memory_order_relaxed);
+        unsigned long frees = atomic_load_explicit(&MemoryByType[i].frees, memory_order_relaxed);
+        size_t live = atomic_load_explicit(&MemoryByType[i].live_bytes, memory_order_relaxed);
+
+        if (allocations == frees && live == 0)
+            continue;
+
+        if (clean)
+            fprintf(out, "== Memory Leaks =================================\n");
+        clean = false;
+        fprintf(out, "%s: %lu allocations never freed, %zu Bytes\n", MemoryTypeStr[i], allocations - frees, live);
+    }
+
+    return clean;
+}
+
+/* Reports leaks on stderr when the program exits, see atexit */
+void ReportMemoryLeaks(void) {
+    FPrintMemoryLeaks(stderr);
+}
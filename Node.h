@@ -20,7 +20,7 @@ struct Node {
 * Creates a new node and returns it's address in memory
 */
 Node* NewNode(unsigned int depth, Board* board, Node* parent) {
-    Node* newNode = malloc(sizeof(Node));
+    Node* newNode = TrackedAlloc(MEMORY_NODE, sizeof(Node));
     if (newNode) {
         newNode->depth = depth;
         newNode->board = board;
@@ -81,8 +81,8 @@ NodeQueue* GetChildNodes(Node* n_parent) {
 /* Used to deallocate memory of a NodeQueue */
 void FreeQueue(Node* n_current) {
     if (n_current->children == NULL) {
-        free(n_current->board);
-        free(n_current);
+        TrackedFree(MEMORY_BOARD, n_current->board, sizeof(Board));
+        TrackedFree(MEMORY_NODE, n_current, sizeof(Node));
         return;
     }
 
@@ -92,11 +92,13 @@ void FreeQueue(Node* n_current) {
     while (gn_current) {
         qn_next = gn_current->qn_next;
         FreeQueue(gn_current->n_current);
+        TrackedFree(MEMORY_QUEUE_NODE, gn_current, sizeof(QueueNode));
         gn_current = qn_next;
     }
 
-    free(n_current->children);
-    free(n_current);
+    TrackedFree(MEMORY_NODE_QUEUE, n_current->children, sizeof(NodeQueue));
+    TrackedFree(MEMORY_BOARD, n_current->board, sizeof(Board));
+    TrackedFree(MEMORY_NODE, n_current, sizeof(Node));
 }
 
 int GetDepthCost(Node* node) {
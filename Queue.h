@@ -27,7 +27,7 @@ struct NodeQueue {
 /* Pushes a node to the queue. */
 void PushNode(Node* node, NodeQueue** const nq) {
     // Placeholder queuenode
-    QueueNode* qn = malloc(sizeof(QueueNode));
+    QueueNode* qn = TrackedAlloc(MEMORY_QUEUE_NODE, sizeof(QueueNode));
 
     // Set the placehold  QueueNode to the node we're pushing
     qn->n_current = node;
@@ -47,7 +47,7 @@ void PushNode(Node* node, NodeQueue** const nq) {
     // Or if the NodeQueue does not exist
     if (*nq == NULL) {
         // Create it!
-        *nq = malloc(sizeof(NodeQueue));
+        *nq = TrackedAlloc(MEMORY_NODE_QUEUE, sizeof(NodeQueue));
         // Initialize it's values and set the tail to the QueueNode
         (*nq)->n_count = 0;
         (*nq)->qn_head = NULL;
@@ -79,7 +79,7 @@ Node* PopNode(NodeQueue** const nq) {
     QueueNode* qn_prev = (*nq)->qn_tail->qn_prev;
 
     // Deallocate node from memory
-    free((*nq)->qn_tail);
+    TrackedFree(MEMORY_QUEUE_NODE, (*nq)->qn_tail, sizeof(QueueNode));
     
     // If the queue now has only 1 element...
     if ((*nq)->n_count == 1) {
@@ -123,10 +123,24 @@ void PushQueue(NodeQueue** nq_source, NodeQueue* nq_dest) {
     nq_dest->n_count += (*nq_source)->n_count;
 
     // Deallocate the source queue from memory
-    free(*nq_source);
+    TrackedFree(MEMORY_NODE_QUEUE, *nq_source, sizeof(NodeQueue));
     *nq_source = NULL;
 }
 
+/* Deallocates a queue and its QueueNodes, leaving the nodes it points to untouched. */
+void ClearQueue(NodeQueue** nq) {
+    if (!*nq) return;
+
+    QueueNode* qn_next;
+    for (QueueNode* qn = (*nq)->qn_head; qn; qn = qn_next) {
+        qn_next = qn->qn_next;
+        TrackedFree(MEMORY_QUEUE_NODE, qn, sizeof(QueueNode));
+    }
+
+    TrackedFree(MEMORY_NODE_QUEUE, *nq, sizeof(NodeQueue));
+    *nq = NULL;
+}
+
 int GetDepthCost(Node*);
 /* Pushes a queue of nodes to a destination queue based ordererd by the depth (path cost from the current node to the root node). */
 void PushQueue_Priority(NodeQueue** nq_source, NodeQueue* nq_dest) {
@@ -187,6 +201,6 @@ void PushQueue_Priority(NodeQueue** nq_source, NodeQueue* nq_dest) {
     }
 
     // Deallocate Memory
-    free(*nq_source);
+    TrackedFree(MEMORY_NODE_QUEUE, *nq_source, sizeof(NodeQueue));
     *nq_source = NULL;
 }
\ No newline at end of file
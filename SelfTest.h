@@ -0,0 +1,550 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "Board.h"
+#include "Algorithm.h"
+#include "IDAStar.h"
+#include "HDAStar.h"
+#include "BestFirst.h"
+#include "Transposition.h"
+#include "Generator.h"
+#include "BatchIO.h"
+#include "ExternalBFS.h"
+#include "Memory.h"
+
+#define SELFTEST_THREADS 4          // Worker threads of HDA*
+#define SELFTEST_TT_BYTES (16 << 20) // Size of the transposition table kept across the instances
+#define SELFTEST_BUDGET 5           // Node budget of the searches checked for giving up in time
+#define SELFTEST_EBFS_INSTANCES 5   // Random instances whose goal distance is checked with the external-memory BFS
+#define SELFTEST_EBFS_STATES 500    // Child buffer of the external-memory BFS spilling to many runs
+#define EIGHT_PUZZLE_STATES 181440  // Boards reachable from any board, half of the 9! permutations
+
+/** Self test
+* Solves random instances with every search and checks the results against each other: the optimal searches
+* (IDA* with and without a transposition table, HDA*) must agree on the number of moves, and every path must
+* actually lead from the initial board to the goal. The bounded-suboptimal searches (see BestFirst.h) must stay
+* within their weight of the optimal number of moves, the bound they report must hold, and every search given a
+* node budget must give up within it. The external-memory BFS (see ExternalBFS.h) must find the same goal distances
+* and visit the whole state space whatever the size of its buffer. Finally the solutions are written to batch files
+* and read back, both directly and through their text format (see BatchIO.h).
+* Run it with --selftest COUNT after changing a search.
+*/
+
+typedef struct SelfTest {
+    FILE* out;
+    unsigned int checks;
+    unsigned int failures;
+} SelfTest;
+
+/* Counts a check, printing it if it failed */
+void SelfTestCheck(SelfTest* t, bool passed, const char* format, ...) {
+    t->checks++;
+    if (passed)
+        return;
+
+    t->failures++;
+    va_list args;
+    va_start(args, format);
+    fprintf(t->out, "FAILED: ");
+    vfprintf(t->out, format, args);
+    fprintf(t->out, "\n");
+    va_end(args);
+}
+
+/* Returns whether the path of a result leads from the initial board to the goal in MovesPerformed moves */
+bool IsPathValid(Algorithm const* algo, Board const* b_init, Board const* b_goal) {
+    if (!algo->path || algo->path->move != NONE)
+        return false;
+
+    uint64_t state = PackBoard(b_init);
+    unsigned int n_moves = 0;
+    for (Path* p = algo->path->next; p && state != 0; p = p->next, n_moves++) {
+        state = PackedApplyMove(state, PackedBlankIndex(state), p->move);
+    }
+
+    return state == PackBoard(b_goal) && n_moves == algo->MovesPerformed;
+}
+
+/** Checks the result of a search that must find an optimal path of optimal moves,
+* or no path at all if optimal is UINT_MAX (the goal is unreachable).
+*/
+void SelfTestOptimal(SelfTest* t, const char* name, unsigned int instance, Algorithm const* algo, Board const* b_init,
+    Board const* b_goal, unsigned int optimal) {
+    if (optimal == UINT_MAX) {
+        SelfTestCheck(t, !algo->Solved && !algo->path, "%s solved unsolvable instance %u", name, instance);
+        SelfTestCheck(t, isinf(algo->Bound), "%s reported a bound of %f without a solution for instance %u",
+            name, algo->Bound, instance);
+        return;
+    }
+
+    SelfTestCheck(t, algo->Solved, "%s did not solve instance %u", name, instance);
+    if (!algo->Solved)
+        return;
+
+    SelfTestCheck(t, IsPathValid(algo, b_init, b_goal), "%s returned an invalid path for instance %u", name, instance);
+    SelfTestCheck(t, algo->MovesPerformed == optimal, "%s found %u moves instead of %u for instance %u",
+        name, algo->MovesPerformed, optimal, instance);
+    SelfTestCheck(t, algo->Bound == 1.0, "%s reported a bound of %f for instance %u", name, algo->Bound, instance);
+}
+
+/* Initial boards (towards the goal of NewBoard) that once made a search fail, checked on every run */
+const char* SelfTestRegressions[] = {
+    "268735104",    // FOCAL:1.5 reported 25 moves for a path of 23 (--seed 2, instance 107)
+};
+
+/* A bounded-suboptimal search to check, see BoundedBestFirst */
+typedef struct SelfTestSearch {
+    const char* name;
+    FrontierMode mode;
+    double weight;
+    unsigned int width;
+    bool complete;          // Always finds a path to a reachable goal
+} SelfTestSearch;
+
+SelfTestSearch SelfTestSearches[] = {
+    { "WA:1", FRONTIER_WEIGHTED, 1.0, 0, true },
+    { "WA:1.5", FRONTIER_WEIGHTED, 1.5, 0, true },
+    { "WA:3", FRONTIER_WEIGHTED, 3.0, 0, true },
+    { "FOCAL:1.5", FRONTIER_FOCAL, 1.5, 0, true },
+    { "FOCAL:3", FRONTIER_FOCAL, 3.0, 0, true },
+    { "GREEDY", FRONTIER_GREEDY, INFINITY, 0, true },
+    { "BEAM:1", FRONTIER_BEAM, INFINITY, 1, false },
+    { "BEAM:100", FRONTIER_BEAM, INFINITY, 100, false },
+    { "BEAM:181440", FRONTIER_BEAM, 1.0, BEAM_MAX_WIDTH, true },   // Never prunes, so it is breadth-first search
+};
+
+/* Checks a bounded-suboptimal search: its path, its weight and the bound it reports */
+void SelfTestBounded(SelfTest* t, SelfTestSearch const* s, unsigned int instance, Board* b_init, Board* b_goal,
+    unsigned int optimal) {
+    Algorithm* algo = BoundedBestFirst(b_init, b_goal, s->mode, s->weight, s->width, UINT_MAX);
+
+    if (optimal == UINT_MAX) {
+        SelfTestCheck(t, !algo->Solved && !algo->path, "%s solved unsolvable instance %u", s->name, instance);
+    }
+    else if (!algo->Solved) {
+        SelfTestCheck(t, !s->complete, "%s did not solve instance %u", s->name, instance);
+        SelfTestCheck(t, !algo->path, "%s returned a path without solving instance %u", s->name, instance);
+    }
+    else {
+        double ratio = optimal > 0 ? (double)algo->MovesPerformed / optimal : 1.0;
+
+        SelfTestCheck(t, IsPathValid(algo, b_init, b_goal), "%s returned an invalid path for instance %u",
+            s->name, instance);
+        SelfTestCheck(t, optimal > 0 || algo->MovesPerformed == 0, "%s found %u moves instead of 0 for instance %u",
+            s->name, algo->MovesPerformed, instance);
+        SelfTestCheck(t, ratio <= s->weight + 1e-9, "%s found %u moves for instance %u, more than %g times the "
+            "optimal %u", s->name, algo->MovesPerformed, instance, s->weight, optimal);
+        SelfTestCheck(t, ratio <= algo->Bound + 1e-9, "%s reported a bound of %f for instance %u, its path is %f "
+            "times the optimal one", s->name, algo->Bound, instance, ratio);
+        SelfTestCheck(t, algo->Bound <= s->weight + 1e-9, "%s reported a bound of %f above its weight for "
+            "instance %u", s->name, algo->Bound, instance);
+    }
+
+    FreeAlgorithm(&algo);
+}
+
+/* Checks that a search given a node budget gives up within it, without a path */
+void SelfTestBudget(SelfTest* t, const char* name, unsigned int instance, Algorithm* algo, unsigned int budget) {
+    SelfTestCheck(t, algo->NodesVisited <= budget, "%s visited %u nodes for instance %u, over its budget of %u",
+        name, algo->NodesVisited, instance, budget);
+    SelfTestCheck(t, algo->Solved || !algo->path, "%s returned a path after running out of budget for instance %u",
+        name, instance);
+    SelfTestCheck(t, algo->Solved || isinf(algo->Bound), "%s reported a bound of %f without a solution for instance %u",
+        name, algo->Bound, instance);
+    FreeAlgorithm(&algo);
+}
+
+/* Solves one instance with every search, the reference is IDA* without a transposition table */
+void SelfTestInstance(SelfTest* t, unsigned int instance, Board* b_init, Board* b_goal, TranspositionTable* tt) {
+    Algorithm* reference = IDAStar(b_init, b_goal, NULL);
+    unsigned int optimal = reference->Solved ? reference->MovesPerformed : UINT_MAX;
+
+    // The reference itself must agree with the solvability test
+    SelfTestCheck(t, reference->Solved == IsBoardSolvable(b_init, b_goal), "IDA* disagrees with IsBoardSolvable "
+        "on instance %u", instance);
+    SelfTestOptimal(t, "IDA*", instance, reference, b_init, b_goal, optimal);
+
+    Algorithm* algo = IDAStar(b_init, b_goal, tt);
+    SelfTestOptimal(t, "IDA* with a transposition table", instance, algo, b_init, b_goal, optimal);
+    FreeAlgorithm(&algo);
+
+    algo = HDAStar(b_init, b_goal, SELFTEST_THREADS);
+    SelfTestOptimal(t, "HDA*", instance, algo, b_init, b_goal, optimal);
+    FreeAlgorithm(&algo);
+
+    for (size_t i = 0; i < sizeof(SelfTestSearches) / sizeof(SelfTestSearch); i++) {
+        SelfTestBounded(t, &SelfTestSearches[i], instance, b_init, b_goal, optimal);
+    }
+
+    SelfTestBudget(t, "IDA*", instance, IDAStar_Bounded(b_init, b_goal, NULL, SELFTEST_BUDGET), SELFTEST_BUDGET);
+    SelfTestBudget(t, "WA:1.5", instance,
+        BoundedBestFirst(b_init, b_goal, FRONTIER_WEIGHTED, 1.5, 0, SELFTEST_BUDGET), SELFTEST_BUDGET);
+    SelfTestBudget(t, "BEAM:100", instance,
+        BoundedBestFirst(b_init, b_goal, FRONTIER_BEAM, 1.0, 100, SELFTEST_BUDGET), SELFTEST_BUDGET);
+
+    // A raised stop flag makes the searches give up as if their budget were 0, see SearchStop
+    if (optimal > 0 && optimal != UINT_MAX) {
+        atomic_bool stop = true;
+        SearchStop = &stop;
+        SelfTestBudget(t, "stopped BFS", instance, BFS_Bounded(b_init, b_goal, UINT_MAX), 0);
+        SelfTestBudget(t, "stopped UCS", instance, UCS_Bounded(b_init, b_goal, UINT_MAX), 0);
+        SelfTestBudget(t, "stopped IDA*", instance, IDAStar_Bounded(b_init, b_goal, NULL, UINT_MAX), 0);
+        SelfTestBudget(t, "stopped WA:1.5", instance, WeightedAStar(b_init, b_goal, 1.5), 0);
+        SelfTestBudget(t, "stopped BEAM:100", instance, BeamSearch(b_init, b_goal, 100), 0);
+        SearchStop = NULL;
+    }
+
+    FreeAlgorithm(&reference);
+}
+
+/* Returns whether a solution record holds a search result, with the bound printed with 6 decimals if rounded */
+bool IsSolutionRecordEqual(BatchSolutionRecord const* record, Algorithm const* algo, uint64_t init, uint64_t goal,
+    bool rounded) {
+    if (!record || record->init != init || record->goal != goal || (record->solved != 0) != algo->Solved
+        || record->nodes_visited != algo->NodesVisited) {
+        return false;
+    }
+
+    if (isinf(algo->Bound) ? record->bound != algo->Bound : fabs(record->bound - algo->Bound) > (rounded ? 1e-6 : 0))
+        return false;
+
+    // Unsolved results are stored without moves
+    uint32_t i = 0;
+    for (Path* p = algo->Solved && algo->path ? algo->path->next : NULL; p; p = p->next, i++) {
+        if (i >= record->moves_performed || GetSolutionMove(record, i) != p->move)
+            return false;
+    }
+
+    return i == record->moves_performed;
+}
+
+/** Checks the external-memory BFS, writing its files to dir: its goal distance against IDA* on a few random
+* instances and an unsolvable one, and full-depth runs from 123456780, whose half of the state space is 31 moves deep,
+* with a large buffer and with one small enough to spill every layer to many runs.
+*/
+void SelfTestExternalBFS(SelfTest* t, Random* r, Board* b_goal, unsigned int count, const char* dir) {
+    Board b_init;
+
+    for (unsigned int i = 0; i <= count && i <= SELFTEST_EBFS_INSTANCES; i++) {
+        NewRandomSolvableBoard(r, b_goal, &b_init);
+        if (i == 0) {
+            // Swapping two tiles flips the inversion parity
+            int* cells = &b_init.config[0][0];
+            int a = cells[0] ? 0 : 2;
+            int b = cells[1] ? 1 : 2;
+            int tmp = cells[a];
+            cells[a] = cells[b];
+            cells[b] = tmp;
+        }
+
+        Algorithm* reference = IDAStar(&b_init, b_goal, NULL);
+        ExternalBFS* ebfs = ExternalBFSRun(&b_init, b_goal, dir, SELFTEST_EBFS_STATES, false);
+        SelfTestCheck(t, ebfs != NULL, "external-memory BFS could not write its files in %s", dir);
+        if (ebfs) {
+            SelfTestCheck(t, ebfs->Solved == reference->Solved
+                && (!ebfs->Solved || ebfs->GoalDistance == reference->MovesPerformed),
+                "external-memory BFS found a goal distance of %u (solved %d) instead of %u (solved %d)",
+                ebfs->GoalDistance, ebfs->Solved, reference->MovesPerformed, reference->Solved);
+            FreeExternalBFS(&ebfs);
+        }
+        FreeAlgorithm(&reference);
+    }
+
+    NewBoardFromString(&b_init, "123456780");
+    ExternalBFS* full[2] = {
+        ExternalBFSRun(&b_init, &b_init, dir, 1 << 16, true),
+        ExternalBFSRun(&b_init, &b_init, dir, SELFTEST_EBFS_STATES, true),
+    };
+
+    for (int run = 0; run < 2; run++) {
+        SelfTestCheck(t, full[run] != NULL, "external-memory BFS could not write its files in %s", dir);
+        if (!full[run])
+            continue;
+
+        uint64_t states = 0;
+        for (unsigned int i = 0; i < full[run]->Layers; i++) {
+            states += full[run]->LayerSizes[i];
+        }
+        SelfTestCheck(t, full[run]->Solved && full[run]->GoalDistance == 0 && full[run]->Layers == 32
+            && states == EIGHT_PUZZLE_STATES && full[run]->StatesVisited == EIGHT_PUZZLE_STATES,
+            "full-depth external-memory BFS %d found %llu states in %u layers instead of %u in 32", run,
+            (unsigned long long)states, full[run]->Layers, EIGHT_PUZZLE_STATES);
+    }
+
+    if (full[0] && full[1]) {
+        bool same = full[0]->Layers == full[1]->Layers;
+        for (unsigned int i = 0; same && i < full[0]->Layers; i++) {
+            same = full[0]->LayerSizes[i] == full[1]->LayerSizes[i];
+        }
+        SelfTestCheck(t, same, "external-memory BFS found other layers with a buffer of %u states",
+            SELFTEST_EBFS_STATES);
+    }
+
+    for (int run = 0; run < 2; run++) {
+        if (full[run])
+            FreeExternalBFS(&full[run]);
+    }
+}
+
+/** Corrupts record 1 of a BATCH_BOARDS file of count records, and checks that converting it to text skips the record
+* and that text holding a malformed or missing board cannot be converted back.
+*/
+void SelfTestCorruptedText(SelfTest* t, const char* path, const char* copy, unsigned int count) {
+    BatchFile* f = OpenBatchFile(path);
+    uint64_t offset = f && f->count > 1 ? f->index[1] + sizeof(BatchRecordHeader) : 0;
+    Board b_init, b_goal;
+    if (offset) {
+        UnpackBoard(GetBoardRecord(f, 1)->init, &b_init);
+        UnpackBoard(GetBoardRecord(f, 1)->goal, &b_goal);
+    }
+    if (f)
+        CloseBatchFile(&f);
+    if (count < 2 || !offset)
+        return;
+
+    // Clear the initial board of the record, keeping its CRC-32
+    FILE* file = fopen(path, "r+b");
+    uint64_t zero = 0;
+    bool corrupted = file && fseek(file, (long)offset, SEEK_SET) == 0 && fwrite(&zero, sizeof(zero), 1, file) == 1;
+    if (file)
+        corrupted = fclose(file) == 0 && corrupted;
+    SelfTestCheck(t, corrupted, "could not corrupt %s", path);
+
+    FILE* text = tmpfile();
+    uint64_t skipped = 0;
+    bool converted = text && BatchToText(path, text, &skipped);
+    SelfTestCheck(t, converted && skipped == 1, "%llu corrupted records of %s skipped instead of 1",
+        (unsigned long long)skipped, path);
+    if (converted) {
+        rewind(text);
+        long written = BoardsTextToBatch(text, copy, false);
+        SelfTestCheck(t, written == (long)count - 1, "%ld records converted back from %s instead of %u", written, path,
+            count - 1);
+    }
+    if (text)
+        fclose(text);
+
+    // A valid pair followed by a goal with a repeated tile, or by no goal at all
+    const char* malformed[2] = { "===\n112\n345\n678\n===\n", "" };
+    for (int m = 0; m < 2; m++) {
+        text = tmpfile();
+        if (!text)
+            continue;
+
+        FPrintBoard(text, &b_init);
+        FPrintBoard(text, &b_goal);
+        FPrintBoard(text, &b_init);
+        fputs(malformed[m], text);
+
+        rewind(text);
+        SelfTestCheck(t, BoardsTextToBatch(text, copy, false) == -1, "malformed text %d converted to a batch file", m);
+        fclose(text);
+    }
+}
+
+/* Corrupts the index of a batch file, and checks that it can neither be read nor reopened to append */
+void SelfTestCorruptedIndex(SelfTest* t, const char* path, BatchRecordType type) {
+    BatchFile* f = OpenBatchFile(path);
+    uint64_t offset = f && f->count > 0 ? f->header->index_offset : 0;
+    if (f)
+        CloseBatchFile(&f);
+    if (!offset)
+        return;
+
+    // Point the first record into the header
+    FILE* file = fopen(path, "r+b");
+    uint64_t bad = 8;
+    bool corrupted = file && fseek(file, (long)offset, SEEK_SET) == 0 && fwrite(&bad, sizeof(bad), 1, file) == 1;
+    if (file)
+        corrupted = fclose(file) == 0 && corrupted;
+    SelfTestCheck(t, corrupted, "could not corrupt the index of %s", path);
+
+    f = OpenBatchFile(path);
+    SelfTestCheck(t, f == NULL, "%s opened with a corrupted index", path);
+    if (f)
+        CloseBatchFile(&f);
+
+    BatchWriter* w = NewBatchWriter(path, type, true);
+    SelfTestCheck(t, w == NULL, "%s reopened to append with a corrupted index", path);
+    if (w)
+        CloseBatchWriter(&w);
+}
+
+/** Solves count instances with weighted A* (the first one unsolvable), writes the boards and the solutions to batch
+* files in dir, appending to the boards half way, and checks the records read back directly and after converting
+* both files to text and back.
+*/
+void SelfTestBatch(SelfTest* t, Random* r, Board* b_goal, unsigned int count, const char* dir) {
+    char boards_path[256], solutions_path[256], boards_copy[256], solutions_copy[256];
+    snprintf(boards_path, sizeof(boards_path), "%s/boards.bin", dir);
+    snprintf(solutions_path, sizeof(solutions_path), "%s/solutions.bin", dir);
+    snprintf(boards_copy, sizeof(boards_copy), "%s/boards-copy.bin", dir);
+    snprintf(solutions_copy, sizeof(solutions_copy), "%s/solutions-copy.bin", dir);
+
+    Algorithm** results = calloc(count, sizeof(Algorithm*));
+    Board* boards = calloc(count, sizeof(Board));
+    bool written = true;
+
+    BatchWriter* w_boards = NewBatchWriter(boards_path, BATCH_BOARDS, false);
+    BatchWriter* w_solutions = NewBatchWriter(solutions_path, BATCH_SOLUTIONS, false);
+    SelfTestCheck(t, w_boards && w_solutions, "could not create batch files in %s", dir);
+
+    for (unsigned int i = 0; i < count && w_boards && w_solutions; i++) {
+        NewRandomSolvableBoard(r, b_goal, &boards[i]);
+        if (i == 0) {
+            // An unsolvable board, whose result has no moves
+            int* cells = &boards[i].config[0][0];
+            int a = cells[0] ? 0 : 2;
+            int b = cells[1] ? 1 : 2;
+            int tmp = cells[a];
+            cells[a] = cells[b];
+            cells[b] = tmp;
+        }
+
+        results[i] = WeightedAStar(&boards[i], b_goal, 1.5);
+        written = written && AppendBoardRecord(w_boards, &boards[i], b_goal)
+            && AppendSolutionRecord(w_solutions, &boards[i], b_goal, results[i]);
+
+        // Reopen the boards half way to append the rest
+        if (i == count / 2) {
+            written = CloseBatchWriter(&w_boards) && written;
+            w_boards = NewBatchWriter(boards_path, BATCH_BOARDS, true);
+            SelfTestCheck(t, w_boards != NULL, "could not reopen %s to append", boards_path);
+        }
+    }
+
+    if (w_boards)
+        written = CloseBatchWriter(&w_boards) && written;
+    if (w_solutions)
+        written = CloseBatchWriter(&w_solutions) && written;
+    SelfTestCheck(t, written, "could not write the batch files in %s", dir);
+
+    // Convert both files to text and back
+    FILE* text = tmpfile();
+    uint64_t corrupted = 0;
+    bool converted = text && BatchToText(boards_path, text, &corrupted) && corrupted == 0;
+    if (converted) {
+        rewind(text);
+        converted = BoardsTextToBatch(text, boards_copy, false) == (long)count;
+    }
+    if (text)
+        fclose(text);
+    SelfTestCheck(t, converted, "could not convert %s to text and back", boards_path);
+
+    text = tmpfile();
+    converted = text && BatchToText(solutions_path, text, &corrupted) && corrupted == 0;
+    if (converted) {
+        rewind(text);
+        converted = SolutionsTextToBatch(text, solutions_copy, false) == (long)count;
+    }
+    if (text)
+        fclose(text);
+    SelfTestCheck(t, converted, "could not convert %s to text and back", solutions_path);
+
+    const char* boards_files[2] = { boards_path, boards_copy };
+    const char* solutions_files[2] = { solutions_path, solutions_copy };
+    uint64_t goal = PackBoard(b_goal);
+
+    for (int copy = 0; copy < 2; copy++) {
+        BatchFile* f = OpenBatchFile(boards_files[copy]);
+        SelfTestCheck(t, f && f->count == count, "%s does not hold %u records", boards_files[copy], count);
+
+        for (unsigned int i = 0; f && i < f->count && i < count; i++) {
+            BatchBoardRecord const* record = GetBoardRecord(f, i);
+            SelfTestCheck(t, record && VerifyBatchRecord(f, i) && record->init == PackBoard(&boards[i])
+                && record->goal == goal, "record %u of %s differs from the board written", i, boards_files[copy]);
+        }
+        if (f)
+            CloseBatchFile(&f);
+
+        f = OpenBatchFile(solutions_files[copy]);
+        SelfTestCheck(t, f && f->count == count, "%s does not hold %u records", solutions_files[copy], count);
+
+        for (unsigned int i = 0; f && i < f->count && i < count; i++) {
+            SelfTestCheck(t, VerifyBatchRecord(f, i) && IsSolutionRecordEqual(GetSolutionRecord(f, i), results[i],
+                PackBoard(&boards[i]), goal, copy == 1), "record %u of %s differs from the solution written", i,
+                solutions_files[copy]);
+        }
+        if (f)
+            CloseBatchFile(&f);
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (results[i])
+            FreeAlgorithm(&results[i]);
+    }
+    free(results);
+    free(boards);
+
+    SelfTestCorruptedText(t, boards_path, boards_copy, count);
+    SelfTestCorruptedIndex(t, solutions_path, BATCH_SOLUTIONS);
+
+    unlink(boards_path);
+    unlink(solutions_path);
+    unlink(boards_copy);
+    unlink(solutions_copy);
+}
+
+/** Runs the self test on count random instances (plus the goal itself, an unsolvable board and the regressions),
+* printing the failed checks and a summary to out. Returns false if any check failed.
+*/
+bool RunSelfTest(FILE* out, uint64_t seed, unsigned int count) {
+    SelfTest t = { out, 0, 0 };
+    TranspositionTable* tt = NewTranspositionTable(SELFTEST_TT_BYTES, REPLACE_SHALLOWER);
+    Board b_init, b_goal;
+    Random r;
+
+    NewBoard(&b_goal, true, false);
+    SeedRandom(&r, seed);
+
+    for (unsigned int i = 0; i < count + 2; i++) {
+        if (i == 0) {
+            b_init = b_goal;
+        }
+        else if (i == 1) {
+            // Swapping two tiles flips the inversion parity
+            NewRandomSolvableBoard(&r, &b_goal, &b_init);
+            int* cells = &b_init.config[0][0];
+            int a = cells[0] ? 0 : 2;
+            int b = cells[1] ? 1 : 2;
+            int tmp = cells[a];
+            cells[a] = cells[b];
+            cells[b] = tmp;
+        }
+        else {
+            NewRandomSolvableBoard(&r, &b_goal, &b_init);
+        }
+
+        SelfTestInstance(&t, i, &b_init, &b_goal, tt);
+    }
+
+    for (size_t i = 0; i < sizeof(SelfTestRegressions) / sizeof(const char*); i++) {
+        NewBoardFromString(&b_init, SelfTestRegressions[i]);
+        SelfTestInstance(&t, count + 2 + (unsigned int)i, &b_init, &b_goal, tt);
+    }
+
+    FreeTranspositionTable(&tt);
+
+    // The layer, run and batch files are written to a fresh directory
+    char dir[] = "/tmp/8puzzle-selftest-XXXXXX";
+    bool created = mkdtemp(dir) != NULL;
+    SelfTestCheck(&t, created, "could not create a directory for the batch files");
+    if (created) {
+        SelfTestExternalBFS(&t, &r, &b_goal, count, dir);
+        SelfTestBatch(&t, &r, &b_goal, count + 1, dir);
+        rmdir(dir);
+    }
+
+    // Every search must have freed everything but the paths of its results, which are freed by now
+    SelfTestCheck(&t, FPrintMemoryLeaks(out), "memory was leaked");
+
+    fprintf(out, "%u checks, %u failed\n", t.checks, t.failures);
+    return t.failures == 0;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "Board.h"
+#include "Frontier.h"
+
+/** Transposition table for depth-first searches
+* A fixed-size, direct-mapped table remembering for each packed board the smallest depth (g) at which it was
+* searched during an iteration, and the best lower bound on its distance to the goal learned so far.
+* Every entry is two words, the data and the data xor'ed with the key. A reader only accepts an entry whose
+* words agree, so the table can be read without locks while another thread writes to it: a torn entry
+* looks like a miss.
+*/
+
+/* What to do when a different board is stored in the slot of the board being written */
+typedef enum Replacement {
+    REPLACE_ALWAYS,     // Always overwrite the slot
+    REPLACE_SHALLOWER,  // Keep the stored board if it is from the current iteration and was searched at a smaller depth
+} Replacement;
+
+typedef struct TTEntry {
+    _Atomic uint64_t check;    // Key xor data, 0 for an empty slot
+    _Atomic uint64_t data;
+} TTEntry;
+
+/* A decoded entry */
+typedef struct TTProbe {
+    unsigned int g;
+    unsigned int bound;
+    unsigned int generation;
+} TTProbe;
+
+typedef struct TranspositionTable {
+    size_t capacity;            // Always a power of two
+    Replacement policy;
+    unsigned int generation;    // Current search iteration, entries from older ones only keep their bound
+    uint64_t goal;              // The goal the bounds were learned for
+
+    TTEntry* entries;
+} TranspositionTable;
+
+/** Creates a table using at most max_bytes of memory for its entries.
+* Returns NULL if max_bytes does not fit a single entry.
+*/
+TranspositionTable* NewTranspositionTable(size_t max_bytes, Replacement policy) {
+    if (max_bytes < sizeof(TTEntry))
+        return NULL;
+
+    // Largest power of two number of entries that fits
+    size_t capacity = 1;
+    while (capacity * 2 * sizeof(TTEntry) <= max_bytes) {
+        capacity *= 2;
+    }
+
+    TranspositionTable* tt = malloc(sizeof(TranspositionTable));
+    tt->capacity = capacity;
+    tt->policy = policy;
+    tt->generation = 0;
+    tt->goal = 0;
+    tt->entries = calloc(capacity, sizeof(TTEntry));
+    return tt;
+}
+
+void FreeTranspositionTable(TranspositionTable** tt) {
+    free((*tt)->entries);
+    free(*tt);
+    *tt = NULL;
+}
+
+/* Empties every slot */
+void ClearTranspositionTable(TranspositionTable* tt) {
+    for (size_t i = 0; i < tt->capacity; i++) {
+        atomic_store_explicit(&tt->entries[i].check, 0, memory_order_relaxed);
+        atomic_store_explicit(&tt->entries[i].data, 0, memory_order_relaxed);
+    }
+    tt->generation = 0;
+}
+
+/* Prepares the table for a search towards goal, dropping bounds learned for another goal */
+void TTBeginSearch(TranspositionTable* tt, uint64_t goal) {
+    if (tt->goal != goal) {
+        ClearTranspositionTable(tt);
+        tt->goal = goal;
+    }
+}
+
+/* Starts a new iteration, the depths stored in earlier iterations no longer prune anything */
+void TTNewGeneration(TranspositionTable* tt) {
+    // The generation is stored in 16 bits, start over before it wraps around
+    if (++tt->generation > 0xFFFF) {
+        uint64_t goal = tt->goal;
+        ClearTranspositionTable(tt);
+        tt->goal = goal;
+        tt->generation = 1;
+    }
+}
+
+TTEntry* TTSlot(TranspositionTable* tt, uint64_t state) {
+    return &tt->entries[HashState(state) & (tt->capacity - 1)];
+}
+
+/* Looks up a board, returns false on a miss */
+bool TTProbeState(TranspositionTable* tt, uint64_t state, TTProbe* probe) {
+    TTEntry* e = TTSlot(tt, state);
+    uint64_t data = atomic_load_explicit(&e->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&e->check, memory_order_relaxed);
+
+    if ((check ^ data) != state)
+        return false;
+
+    probe->g = (unsigned int)(data & 0xFFFF);
+    probe->bound = (unsigned int)((data >> 16) & 0xFFFF);
+    probe->generation = (unsigned int)((data >> 32) & 0xFFFF);
+    return true;
+}
+
+/* Stores the depth and lower bound of a board in the current generation, subject to the replacement policy */
+void TTStore(TranspositionTable* tt, uint64_t state, unsigned int g, unsigned int bound) {
+    TTEntry* e = TTSlot(tt, state);
+    uint64_t old_data = atomic_load_explicit(&e->data, memory_order_relaxed);
+    uint64_t old_key = atomic_load_explicit(&e->check, memory_order_relaxed) ^ old_data;
+
+    if (tt->policy == REPLACE_SHALLOWER && old_key != state && old_key != 0
+        && ((old_data >> 32) & 0xFFFF) == tt->generation && (old_data & 0xFFFF) < g) {
+        return;
+    }
+
+    if (g > 0xFFFF)
+        g = 0xFFFF;
+    if (bound > 0xFFFF)
+        bound = 0xFFFF;
+
+    uint64_t data = (uint64_t)g | ((uint64_t)bound << 16) | ((uint64_t)tt->generation << 32);
+    atomic_store_explicit(&e->data, data, memory_order_relaxed);
+    atomic_store_explicit(&e->check, state ^ data, memory_order_relaxed);
+}
@@ -1,14 +1,235 @@
 #include<stdio.h>
 #include<stdlib.h>
 #include<time.h>
+#include<string.h>
 
 #include "Board.h"
 #include "Queue.h"
 #include "Node.h"
 #include "Algorithm.h"
+#include "Daemon.h"
+#include "HDAStar.h"
+#include "IDAStar.h"
+#include "BestFirst.h"
+#include "ExternalBFS.h"
+#include "Generator.h"
+#include "BatchIO.h"
+#include "SelfTest.h"
 
-int main(void) {
-    srand(time(NULL));
+/**
+* Usage: 8puzzle [--seed N] [--daemon | --socket PATH | --generate COUNT PATH [--depth DEPTH]
+*                 | --solve-batch IN OUT | --import-boards TEXT OUT | --import-solutions TEXT OUT | --export IN
+*                 | --selftest COUNT] [--append]
+*   --seed N               Seed the random number generators for reproducible runs
+*   --daemon               Serve solve requests on stdin/stdout (see Daemon.h)
+*   --socket PATH          Serve solve requests on a Unix-domain socket
+*   --generate COUNT PATH  Write COUNT solvable boards to a file of packed boards (see Generator.h)
+*   --depth DEPTH          Generate boards exactly DEPTH moves away from the goal instead of uniformly
+*   --solve-batch IN OUT   Solve every board of the batch file IN with IDA*, writing the solutions to OUT
+*   --import-boards TEXT OUT     Convert pairs of boards printed by PrintBoard to a batch file (see BatchIO.h)
+*   --import-solutions TEXT OUT  Convert solutions printed by --export to a batch file
+*   --export IN            Print every record of the batch file IN
+*   --append               Add the records to OUT instead of replacing it
+*   --selftest COUNT       Check the searches against each other on COUNT random instances (see SelfTest.h)
+*/
+int main(int argc, char** argv) {
+    unsigned int seed = (unsigned int)time(NULL);
+    bool daemon = false;
+    const char* socket_path = NULL;
+    const char* generate_path = NULL;
+    size_t generate_count = 0;
+    unsigned int depth = 0;
+    const char* batch_in = NULL;
+    const char* batch_out = NULL;
+    const char* import_boards = NULL;
+    const char* import_solutions = NULL;
+    const char* export_path = NULL;
+    bool append = false;
+    unsigned int selftest_count = 0;
+    bool selftest = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--daemon") == 0) {
+            daemon = true;
+        }
+        else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--generate") == 0 && i + 2 < argc) {
+            generate_count = (size_t)strtoull(argv[++i], NULL, 10);
+            generate_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = (unsigned int)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--solve-batch") == 0 && i + 2 < argc) {
+            batch_in = argv[++i];
+            batch_out = argv[++i];
+        }
+        else if (strcmp(argv[i], "--import-boards") == 0 && i + 2 < argc) {
+            import_boards = argv[++i];
+            batch_out = argv[++i];
+        }
+        else if (strcmp(argv[i], "--import-solutions") == 0 && i + 2 < argc) {
+            import_solutions = argv[++i];
+            batch_out = argv[++i];
+        }
+        else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            export_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--append") == 0) {
+            append = true;
+        }
+        else if (strcmp(argv[i], "--selftest") == 0 && i + 1 < argc) {
+            selftest = true;
+            selftest_count = (unsigned int)strtoul(argv[++i], NULL, 10);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--seed N] [--daemon | --socket PATH | --generate COUNT PATH [--depth DEPTH]"
+                " | --solve-batch IN OUT | --import-boards TEXT OUT | --import-solutions TEXT OUT | --export IN"
+                " | --selftest COUNT] [--append]\n",
+                argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    srand(seed);
+
+    // Report anything the searches did not free when the program ends
+    atexit(ReportMemoryLeaks);
+
+    /* Self Test */
+    if (selftest)
+        return RunSelfTest(stdout, seed, selftest_count) ? 0 : EXIT_FAILURE;
+
+    /* Instance Generator */
+    if (generate_path) {
+        Board b_goal;
+        NewBoard(&b_goal, true, false);
+
+        DepthShell shell = { NULL, 0 };
+        if (depth > 0 && !NewDepthShell(&shell, &b_goal, depth)) {
+            FreeDepthShell(&shell);
+            fprintf(stderr, "No board is %u moves away from the goal\n", depth);
+            return EXIT_FAILURE;
+        }
+
+        Random r;
+        SeedRandom(&r, seed);
+        bool success = WriteInstanceBatch(generate_path, &r, &b_goal, generate_count, depth > 0 ? &shell : NULL,
+            append);
+        FreeDepthShell(&shell);
+        if (!success) {
+            fprintf(stderr, "Could not write %s\n", generate_path);
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
+
+    /* Batch Files */
+    if (import_boards || import_solutions) {
+        const char* text_path = import_boards ? import_boards : import_solutions;
+        FILE* text = fopen(text_path, "r");
+        if (!text) {
+            fprintf(stderr, "Could not read %s\n", text_path);
+            return EXIT_FAILURE;
+        }
+
+        long count = import_boards ? BoardsTextToBatch(text, batch_out, append) : SolutionsTextToBatch(text, batch_out, append);
+        fclose(text);
+        if (count < 0) {
+            fprintf(stderr, "Could not convert %s to %s\n", text_path, batch_out);
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
+
+    if (export_path) {
+        uint64_t corrupted;
+        if (!BatchToText(export_path, stdout, &corrupted)) {
+            fprintf(stderr, "Could not read %s\n", export_path);
+            return EXIT_FAILURE;
+        }
+        if (corrupted > 0) {
+            fprintf(stderr, "Skipped %llu corrupted records of %s\n", (unsigned long long)corrupted, export_path);
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
+
+    if (batch_in) {
+        BatchFile* in = OpenBatchFile(batch_in);
+        if (!in || in->header->record_type != BATCH_BOARDS) {
+            fprintf(stderr, "Could not read boards from %s\n", batch_in);
+            return EXIT_FAILURE;
+        }
+
+        BatchWriter* out = NewBatchWriter(batch_out, BATCH_SOLUTIONS, append);
+        if (!out) {
+            CloseBatchFile(&in);
+            fprintf(stderr, "Could not write %s\n", batch_out);
+            return EXIT_FAILURE;
+        }
+
+        // The table is kept between boards sharing a goal, see IDAStar
+        TranspositionTable* tt = NewTranspositionTable(64 << 20, REPLACE_SHALLOWER);
+        bool success = true;
+        Board b_init, b_goal;
+
+        for (uint64_t i = 0; i < in->count && success; i++) {
+            BatchBoardRecord const* record = GetBoardRecord(in, i);
+            bool readable = record && IsPackedBoardValid(record->init) && IsPackedBoardValid(record->goal);
+
+            // Keep solution i matching board i: a corrupted record is written as unsolved, with its boards if
+            // they can still be read (zeroed otherwise)
+            memset(&b_init, 0, sizeof(Board));
+            memset(&b_goal, 0, sizeof(Board));
+            if (readable) {
+                UnpackBoard(record->init, &b_init);
+                UnpackBoard(record->goal, &b_goal);
+            }
+
+            if (!readable || !VerifyBatchRecord(in, i)) {
+                fprintf(stderr, "Corrupted record %llu, written as unsolved\n", (unsigned long long)i);
+                Algorithm unsolved = { .Solved = false, .Bound = INFINITY };
+                success = AppendSolutionRecord(out, &b_init, &b_goal, &unsolved);
+                continue;
+            }
+
+            Algorithm* algo = IDAStar(&b_init, &b_goal, tt);
+            success = AppendSolutionRecord(out, &b_init, &b_goal, algo);
+            FreeAlgorithm(&algo);
+        }
+
+        FreeTranspositionTable(&tt);
+        CloseBatchFile(&in);
+        if (!CloseBatchWriter(&out) || !success) {
+            fprintf(stderr, "Could not write %s\n", batch_out);
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
+
+    /* Solver Daemon */
+    if (daemon || socket_path) {
+        Daemon* d = NewDaemon();
+        bool success = true;
+
+        if (socket_path)
+            success = RunDaemonSocket(d, socket_path);
+        else
+            RunDaemon(d, stdin, stdout);
+
+        FreeDaemon(&d);
+        if (!success) {
+            fprintf(stderr, "Could not listen on %s\n", socket_path);
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
 
     Board b_init; // Initial board
     Board b_goal; // Goal board
@@ -39,11 +260,43 @@ int main(void) {
     PrintAlgorithm(A_UCS);
     FreeAlgorithm(&A_UCS);
     */
+    /* Hash-Distributed A* (HDA*)
+    printf("--- HASH-DISTRIBUTED A* ---\n");
+    Algorithm* A_HDA;
+    A_HDA = HDAStar(&b_init, &b_goal, 4);
+    PrintAlgorithm(A_HDA);
+    FreeAlgorithm(&A_HDA);
+    */
+    /* Iterative-Deepening A* (IDA*) with a 64 MB transposition table
+    printf("--- ITERATIVE DEEPENING A* ---\n");
+    TranspositionTable* tt = NewTranspositionTable(64 << 20, REPLACE_SHALLOWER);
+    Algorithm* A_IDA;
+    A_IDA = IDAStar(&b_init, &b_goal, tt);
+    PrintAlgorithm(A_IDA);
+    FreeAlgorithm(&A_IDA);
+    FreeTranspositionTable(&tt);
+    */
+    /* Weighted A* (at most 1.5 times the optimal number of moves)
+    printf("--- WEIGHTED A* ---\n");
+    Algorithm* A_WA;
+    A_WA = WeightedAStar(&b_init, &b_goal, 1.5);
+    PrintAlgorithm(A_WA);
+    FreeAlgorithm(&A_WA);
+    */
+    /* External-Memory Breadth-First Search, computing every layer of the state space
+    printf("--- EXTERNAL-MEMORY BREADTH FIRST SEARCH ---\n");
+    ExternalBFS* E_BFS;
+    E_BFS = ExternalBFSRun(&b_init, &b_goal, "/tmp", 1 << 20, true);
+    PrintExternalBFS(E_BFS);
+    FreeExternalBFS(&E_BFS);
+    */
 
     /* Simulated Annealing (SA) */
     printf("--- SIMULATED ANNEALING ---\n");
     Algorithm* A_SA;
     A_SA = SA(&b_init, &b_goal);
+    FPrintMemoryStats(stdout, &A_SA->Memory);
+    FreeAlgorithm(&A_SA);
 
     return 0;
 }